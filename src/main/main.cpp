@@ -1,16 +1,60 @@
 #include <iostream>
 #include "../mesh/Mesh.h"
 #include "../msc2d/mscomplex.h"
+#include "../msc2d/scalar_field_io.h"
 #include <boost/shared_ptr.hpp>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 using namespace std;
 int main(int argc, char** argv)
 {
   if(argc <3) {
     cout << "Usage: msc2d mesh-file scalar-field-file"<< endl;
+    cout << "       msc2d --convert sf-file sfb-file [f32|f64]"<< endl;
+    cout << "       msc2d --batch mesh-file sf-file... | msf-file"<< endl;
     return -1;
   }
+
+  if(string(argv[1]) == "--convert"){
+    if(argc < 4) {
+      cout << "Usage: msc2d --convert sf-file sfb-file [f32|f64]"<< endl;
+      return -1;
+    }
+    msc2d::ScalarFieldDType dtype = msc2d::SFB_FLOAT64;
+    if(argc > 4 && string(argv[4]) == "f32") dtype = msc2d::SFB_FLOAT32;
+    return msc2d::convertScalarField(argv[2], argv[3], dtype) ? 0 : -1;
+  }
+
+  if(string(argv[1]) == "--batch"){
+    if(argc < 4) {
+      cout << "Usage: msc2d --batch mesh-file sf-file... | msf-file"<< endl;
+      return -1;
+    }
+    //! one mesh shared by all worker threads, OMP_NUM_THREADS sets their number
+    boost::shared_ptr<meshlib::Mesh> mesh(new meshlib::Mesh);
+    if(!mesh->attachModel(argv[2])) return -1;
+    vector<string> msc_files;
+    string first = argv[3];
+    if(argc == 4 && first.size() > 4 && first.substr(first.size()-4) == ".msf"){
+      //! one output per column: fields.msf -> fields_0.msc, fields_1.msc ...
+      vector< vector<double> > fields;
+      if(!msc2d::loadMultiScalarField(first, fields)) return -1;
+      for(size_t k=0; k<fields.size(); ++k){
+        ostringstream oss;
+        oss << first.substr(0, first.size()-4) << "_" << k << ".msc";
+        msc_files.push_back(oss.str());
+      }
+      return msc2d::createMSComplex2DParallel(mesh, fields, msc_files, 0.003) ? 0 : -1;
+    }
+    vector<string> sf_files(argv+3, argv+argc);
+    for(size_t k=0; k<sf_files.size(); ++k){
+      size_t dot = sf_files[k].rfind('.');
+      msc_files.push_back(sf_files[k].substr(0, dot) + ".msc");
+    }
+    return msc2d::createMSComplex2DParallel(mesh, sf_files, msc_files, 0.003) ? 0 : -1;
+  }
   
   msc2d::MSComplex2D msc;
   msc.setMesh(argv[1]);
@@ -19,14 +63,15 @@ int main(int argc, char** argv)
   string sf_filename = argv[2];
   size_t idx = sf_filename.rfind(".sf");
   if(idx != string::npos){
+    size_t ext_len = sf_filename.size() - idx;
     string msc_filename = sf_filename;
-    msc_filename.replace(idx, ".sf", ".msc");
+    msc_filename.replace(idx, ext_len, ".msc");
     //cout << msc_filename << endl;
     msc.saveMSComplex(msc_filename);
     ofstream fout(msc_filename.c_str());
     fout << msc;
     string dual_msc_fn = sf_filename;
-    dual_msc_fn.replace(idx, ".sf", ".quad");
+    dual_msc_fn.replace(idx, ext_len, ".quad");
    // msc.createDualMSComplex2D(dual_msc_fn, 0.003);
   }
 
@@ -3,6 +3,10 @@
 #include "MeshIO.h"
 #include "MeshBasicOp.h"
 #include "MeshInfo.h"
+#include "../util/utility.h"
+#include <iostream>
+
+using namespace std;
 
 namespace meshlib{
     
@@ -10,7 +14,7 @@ Mesh::Mesh(){}
 Mesh::~Mesh(){}
 
 // Input/Output functions
-bool Mesh::attachModel(const std::string& filename){
+bool Mesh::attachModel(const std::string& filename, int load_flag){
 
   p_Kernel.reset(); p_IO.reset(); p_BasicOP.reset(); p_Info.reset();
     
@@ -19,9 +23,25 @@ bool Mesh::attachModel(const std::string& filename){
   p_BasicOP = boost::shared_ptr<MeshBasicOP> (new MeshBasicOP(*this));
   p_Info = boost::shared_ptr<MeshInfo> (new MeshInfo(*this));
     
-  if(!p_IO->LoadModel(filename)) return false;
+  //! a cache is valid only for the exact source file it was built from
+  unsigned long long source_hash = 0;
+  std::string cache_name;
+  bool use_cache = Util::IsSetFlag(load_flag, (int)LOAD_CACHE) &&
+      MeshIO::HashSourceFile(filename, source_hash);
+  if(use_cache){
+    cache_name = MeshIO::CacheFileName(filename);
+    if(p_IO->LoadCache(cache_name, source_hash)) return true;
+    p_Kernel.reset(new MeshKernel(*this));
+    p_BasicOP.reset(new MeshBasicOP(*this));
+    p_Info.reset(new MeshInfo(*this));
+  }
+
+  if(!p_IO->LoadModel(filename, load_flag)) return false;
 
   p_BasicOP->initModel();
+  if(use_cache && !p_IO->StoreCache(cache_name, source_hash)){
+    cerr << "cannot write mesh cache " << cache_name << endl;
+  }
   return true;
 }
 
@@ -45,16 +65,31 @@ const Coord3D& Mesh::getFaceNorm(FaceHandle fh) const
   return p_Kernel->getFaceArray()[fh].normal;
 }
 
-const std::vector<VertHandle>& Mesh::getAdjVertices(VertHandle vh) const
+VertHandleSpan Mesh::getAdjVertices(VertHandle vh) const
 {
   return p_BasicOP->getAdjVertArray(vh);
 }
     
-const std::vector<FaceHandle>& Mesh::getAdjFaces(VertHandle vh) const
+FaceHandleSpan Mesh::getAdjFaces(VertHandle vh) const
 {
   return p_BasicOP->getAdjFaceArray(vh);
 }
 
+EdgeHandleSpan Mesh::getAdjEdges(VertHandle vh) const
+{
+  return p_BasicOP->getAdjEdgeArray(vh);
+}
+
+DoubleSpan Mesh::getAdjEdgeLengths(VertHandle vh) const
+{
+  return p_BasicOP->getAdjEdgeLengthArray(vh);
+}
+
+int Mesh::getAdjSlotOffset(VertHandle vh) const
+{
+  return p_BasicOP->getAdjSlotOffset(vh);
+}
+
 const std::vector<VertHandle>& Mesh::getFaceVertices(FaceHandle fh) const
 {
   return p_Kernel->getFaceArray()[fh].vert_handle_vec;
@@ -13,6 +13,14 @@ namespace meshlib{
   class MeshIO;
   class MeshBasicOP;
   class MeshInfo;
+
+  //! options of Mesh::attachModel
+  enum LOADFLAG{
+    LOAD_STREAM = 0x00000000, // two pass getline/stringstream obj parser
+    LOAD_MMAP = 0x00000001,   // single pass obj parser over the mapped file
+    LOAD_PARALLEL = 0x00000002, // chunked multi-threaded parse of the mapped file
+    LOAD_CACHE = 0x00000004     // read/write the .mshb topology cache next to the model
+  };
     
   class Mesh
   {
@@ -22,7 +30,7 @@ namespace meshlib{
     ~Mesh();
         
     // Input/Output functions
-    bool attachModel(const std::string& filename);
+    bool attachModel(const std::string& filename, int load_flag = LOAD_MMAP);
     bool storeModel(const std::string& filename) const;
 
     size_t getVertexNumber() const;
@@ -33,8 +41,15 @@ namespace meshlib{
     const Coord3D& getVertexNorm(VertHandle vh) const;
     const Coord3D& getFaceNorm(FaceHandle fh) const;
 
-    const VertHandleArray& getAdjVertices(VertHandle vh) const;
-    const FaceHandleArray& getAdjFaces(VertHandle vh) const;
+    VertHandleSpan getAdjVertices(VertHandle vh) const;
+    FaceHandleSpan getAdjFaces(VertHandle vh) const;
+    //! edges to the one-ring vertices, aligned with getAdjVertices
+    EdgeHandleSpan getAdjEdges(VertHandle vh) const;
+    //! lengths of the edges to the one-ring vertices, aligned with getAdjVertices
+    DoubleSpan getAdjEdgeLengths(VertHandle vh) const;
+    //! position of the first one-ring slot of vh in arrays over all slots,
+    //! vh = getVertexNumber() gives the number of slots
+    int getAdjSlotOffset(VertHandle vh) const;
     const VertHandleArray& getFaceVertices(FaceHandle fh) const;
     const EdgeHandleArray& getFaceEdges(FaceHandle fh) const;
     const HalfEdgeHandleArray& getFaceHalfEdges(FaceHandle fh) const;
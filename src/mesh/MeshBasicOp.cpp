@@ -3,7 +3,8 @@
 #include "MeshKernel.h"
 #include "MeshInfo.h"
 #include "../util/utility.h"
-#include "../util/heap.h"
+#include "MeshPathFinder.h"
+#include "../util/radix_sort.h"
 #include <queue>
 #include <algorithm>
 #include <cmath>
@@ -46,34 +47,84 @@ void MeshBasicOP::initModel()
     genHalfEdgeDS(); 
   }
   sortAdjacentInfo();  
+  genVertSlotInfo();
+  genVertSlotLength();
 }
 
 void MeshBasicOP::genEdgeInfo()
-{ 
-
-#define MKEDGE(u,v) ((u>v)?make_pair(v,u):make_pair(u,v))  
-  map< pair<VertHandle, VertHandle>, EdgeHandle > vert_edge_mp;
-  map< pair<VertHandle, VertHandle>, EdgeHandle >::iterator im;
+{
+  //! corner i of face fid has the global index corner_offset[fid]+i and
+  //! stands for the edge from its vertex to the next one of the face
+  int face_num = (int)mesh.getFaceNumber();
+  vector<size_t> corner_offset(face_num+1, 0);
+  for(int fid=0; fid<face_num; ++fid)
+    corner_offset[fid+1] = corner_offset[fid] + face_vec[fid].vert_handle_vec.size();
+  size_t corner_num = corner_offset[face_num];
+
+  int vert_bits = 1;
+  while(((size_t)1 << vert_bits) < mesh.getVertexNumber()) ++vert_bits;
+
+  //! key (min vertex, max vertex), value corner index
+  vector< pair<unsigned long long, unsigned int> > corner_key(corner_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int fid=0; fid<face_num; ++fid){
+    const VertHandleArray& vh_vec = face_vec[fid].vert_handle_vec;
+    for(size_t i=0; i<vh_vec.size(); ++i){
+      unsigned long long u = vh_vec[i], v = vh_vec[(i+1)%vh_vec.size()];
+      if(u > v) swap(u, v);
+      size_t c = corner_offset[fid]+i;
+      corner_key[c] = make_pair((u << vert_bits) | v, (unsigned int)c);
+    }
+  }
+  RadixSort(corner_key, 2*vert_bits);
+
+  //! the sort is stable, so each run of equal keys starts with the corner
+  //! that meets the edge first. numbering those corners in corner order
+  //! gives the same edge ids as a face-by-face scan
+  vector<char> first_flag(corner_num, 0);
+  for(size_t k=0; k<corner_num; ++k){
+    if(k==0 || corner_key[k].first != corner_key[k-1].first)
+      first_flag[corner_key[k].second] = 1;
+  }
+  vector<int> corner_eh(corner_num);
+  int edge_num = 0;
+  for(size_t c=0; c<corner_num; ++c){
+    if(first_flag[c]) corner_eh[c] = edge_num++;
+  }
+  int run_eh = -1;
+  for(size_t k=0; k<corner_num; ++k){
+    unsigned int c = corner_key[k].second;
+    if(first_flag[c]) run_eh = corner_eh[c];
+    else corner_eh[c] = run_eh;
+  }
 
-  size_t edge_num = 0;
-  for(size_t fid=0; fid<mesh.getFaceNumber(); ++fid){
+  edge_vec.clear(); edge_vec.resize(edge_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int fid=0; fid<face_num; ++fid){
     const VertHandleArray& vh_vec = face_vec[fid].vert_handle_vec;
     EdgeHandleArray& eh_vec = face_vec[fid].edge_handle_vec;
-    eh_vec.clear(); eh_vec.resize(vh_vec.size());
+    eh_vec.resize(vh_vec.size());
     for(size_t i=0; i<vh_vec.size(); ++i){
-      pair<VertHandle, VertHandle> ep = MKEDGE(vh_vec[i], vh_vec[(i+1)%vh_vec.size()]);
-      Edge e(vh_vec[i], vh_vec[(i+1)%vh_vec.size()]);
-      im = vert_edge_mp.find(ep);
-      if(im == vert_edge_mp.end()){
-        eh_vec[i] = edge_num;
-        vert_edge_mp[ep] = edge_num++;
-        edge_vec.push_back(e);
-      }else{
-        eh_vec[i] = im->second;
-      }      
+      size_t c = corner_offset[fid]+i;
+      eh_vec[i] = corner_eh[c];
+      if(first_flag[c]) edge_vec[corner_eh[c]] = Edge(vh_vec[i], vh_vec[(i+1)%vh_vec.size()]);
     }
   }
-#undef MKEDGE
+}
+
+namespace{
+//! turn per-row counts stored in offset[1..n] into row offsets, and
+//! return the fill position of every row
+vector<int> prefixSumCSR(HandleCSR& csr)
+{
+  for(size_t k=1; k<csr.offset.size(); ++k) csr.offset[k] += csr.offset[k-1];
+  csr.index.resize(csr.offset.back());
+  return vector<int>(csr.offset.begin(), csr.offset.end()-1);
+}
 }
 
 void MeshBasicOP::genVertAdjacentInfo()
@@ -81,25 +132,40 @@ void MeshBasicOP::genVertAdjacentInfo()
   size_t vert_num = mesh.getVertexNumber();
   size_t face_num = mesh.getFaceNumber();
   size_t edge_num = mesh.getEdgeNumber();
-  vert_adj_vert_vec.clear(); vert_adj_vert_vec.resize(vert_num);
-  vert_adj_face_vec.clear(); vert_adj_face_vec.resize(vert_num);
-  vert_adj_edge_vec.clear(); vert_adj_edge_vec.resize(vert_num);
+  vert_adj_vert_csr.offset.assign(vert_num+1, 0);
+  vert_adj_face_csr.offset.assign(vert_num+1, 0);
 
+  //! first pass counts the row sizes, second pass fills the rows
+  for(size_t fid=0; fid < face_num; ++fid){
+    const VertHandleArray& vh_vec = face_vec[fid].vert_handle_vec;
+    for(size_t i=0; i<vh_vec.size(); ++i) ++vert_adj_face_csr.offset[vh_vec[i]+1];
+  }
+  for(size_t eid=0; eid < edge_num; ++eid){
+    const Edge& e = edge_vec[eid];
+    ++vert_adj_vert_csr.offset[e.vert_handle_1+1];
+    ++vert_adj_vert_csr.offset[e.vert_handle_2+1];
+  }
+
+  vector<int> face_pos = prefixSumCSR(vert_adj_face_csr);
   for(size_t fid=0; fid < face_num; ++fid){
     const VertHandleArray& vh_vec = face_vec[fid].vert_handle_vec;
     for(size_t i=0; i<vh_vec.size(); ++i){
       const VertHandle& vh = vh_vec[i];
-      vert_adj_face_vec[vh].push_back(fid);
+      vert_adj_face_csr.index[face_pos[vh]++] = fid;
     }
   }
 
+  //! vertices and edges around a vertex share the row layout
+  vector<int> vert_pos = prefixSumCSR(vert_adj_vert_csr);
+  vert_adj_edge_csr = vert_adj_vert_csr;
   for(size_t eid=0; eid < edge_num; ++eid){
     const Edge& e = edge_vec[eid];
-    vert_adj_vert_vec[e.vert_handle_1].push_back(e.vert_handle_2);
-    vert_adj_vert_vec[e.vert_handle_2].push_back(e.vert_handle_1);
-    vert_adj_edge_vec[e.vert_handle_1].push_back(eid);
-    vert_adj_edge_vec[e.vert_handle_2].push_back(eid);
-  }  
+    int pos1 = vert_pos[e.vert_handle_1]++, pos2 = vert_pos[e.vert_handle_2]++;
+    vert_adj_vert_csr.index[pos1] = e.vert_handle_2;
+    vert_adj_vert_csr.index[pos2] = e.vert_handle_1;
+    vert_adj_edge_csr.index[pos1] = eid;
+    vert_adj_edge_csr.index[pos2] = eid;
+  }
 }
 
 void MeshBasicOP::genEdgeAdjacentInfo()
@@ -107,14 +173,18 @@ void MeshBasicOP::genEdgeAdjacentInfo()
   size_t edge_num = mesh.getEdgeNumber();
   size_t face_num = mesh.getFaceNumber();
 
-  edge_adj_face_vec.clear();
-  edge_adj_face_vec.resize(edge_num);
+  edge_adj_face_csr.offset.assign(edge_num+1, 0);
+  for(size_t fid = 0; fid < face_num; ++fid){
+    const EdgeHandleArray& eh_vec = face_vec[fid].edge_handle_vec;
+    for(size_t i=0; i<eh_vec.size(); ++i) ++edge_adj_face_csr.offset[eh_vec[i]+1];
+  }
 
+  vector<int> pos = prefixSumCSR(edge_adj_face_csr);
   for(size_t fid = 0; fid < face_num; ++fid){
-    const Face& f = (mesh.p_Kernel->face_vec)[fid];
-    for(size_t i=0; i<f.edge_handle_vec.size(); ++i){
-      EdgeHandle eh = f.edge_handle_vec[i];
-      edge_adj_face_vec[eh].push_back(fid);
+    const EdgeHandleArray& eh_vec = face_vec[fid].edge_handle_vec;
+    for(size_t i=0; i<eh_vec.size(); ++i){
+      EdgeHandle eh = eh_vec[i];
+      edge_adj_face_csr.index[pos[eh]++] = fid;
     }
   }
 }
@@ -123,54 +193,99 @@ void MeshBasicOP::genFaceAdjacentInfo()
 {
   size_t face_num = mesh.getFaceNumber();
 
-  face_adj_face_vec.clear();
-  face_adj_face_vec.resize(face_num);
+  //! rows are produced in face order, so they are appended directly
+  face_adj_face_csr.clear();
+  face_adj_face_csr.offset.reserve(face_num+1);
+  face_adj_face_csr.index.reserve(edge_adj_face_csr.index.size());
   for(size_t fid = 0; fid < face_num; ++fid){
-    const Face& f = (mesh.p_Kernel->face_vec)[fid];
+    const Face& f = face_vec[fid];
     for(size_t i=0; i<f.edge_handle_vec.size(); ++i){
-      EdgeHandle eh = f.edge_handle_vec[i];
-      const FaceHandleArray& fh_vec = edge_adj_face_vec[eh];
+      FaceHandleSpan fh_vec = edge_adj_face_csr[f.edge_handle_vec[i]];
       for(size_t j=0; j<fh_vec.size(); ++j){
-        if(fh_vec[j] != fid) face_adj_face_vec[fid].push_back(fh_vec[j]);
+        if(fh_vec[j] != fid) face_adj_face_csr.index.push_back(fh_vec[j]);
       }
     }
+    face_adj_face_csr.offset.push_back(face_adj_face_csr.index.size());
   }
 }
 
-const VertHandleArray& MeshBasicOP::getAdjVertArray(const VertHandle& vh) const
+VertHandleSpan MeshBasicOP::getAdjVertArray(const VertHandle& vh) const
 {
-  return vert_adj_vert_vec[vh];
+  return vert_adj_vert_csr[vh];
 }
 
-const VertHandleArray& MeshBasicOP::getAdjFaceArray(const FaceHandle& vh) const
+FaceHandleSpan MeshBasicOP::getAdjFaceArray(const FaceHandle& vh) const
 {
-  return vert_adj_face_vec[vh];
+  return vert_adj_face_csr[vh];
+}
+
+void MeshBasicOP::genVertSlotInfo()
+{
+  int vert_num = (int)mesh.getVertexNumber();
+  vert_slot_edge_vec.assign(vert_adj_vert_csr.index.size(), -1);
+  vert_slot_he_vec.assign(vert_adj_vert_csr.index.size(), -1);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid=0; vid<vert_num; ++vid){
+    VertHandleSpan adj_verts = vert_adj_vert_csr[vid];
+    EdgeHandleSpan adj_edges = vert_adj_edge_csr[vid];
+    int offset = vert_adj_vert_csr.offset[vid];
+    for(size_t k=0; k<adj_edges.size(); ++k){
+      const Edge& e = edge_vec[adj_edges[k]];
+      VertHandle adj_vid = (e.vert_handle_1 == vid) ? e.vert_handle_2 : e.vert_handle_1;
+      size_t slot = find(adj_verts.begin(), adj_verts.end(), adj_vid) - adj_verts.begin();
+      assert(slot != adj_verts.size());
+      vert_slot_edge_vec[offset+slot] = adj_edges[k];
+      for(int i=0; i<2; ++i){
+        HalfEdgeHandle hh = (i == 0) ? e.he_handle_1 : e.he_handle_2;
+        if(hh != -1 && he_vec[hh].vert_handle == vid) vert_slot_he_vec[offset+slot] = hh;
+      }
+    }
+  }
+}
+
+void MeshBasicOP::genVertSlotLength()
+{
+  int vert_num = (int)mesh.getVertexNumber();
+  vert_slot_len_vec.resize(vert_adj_vert_csr.index.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid=0; vid<vert_num; ++vid){
+    const Coord3D& vc = vert_vec[vid].coord;
+    for(int k=vert_adj_vert_csr.offset[vid]; k<vert_adj_vert_csr.offset[vid+1]; ++k)
+      vert_slot_len_vec[k] = (vc - vert_vec[vert_adj_vert_csr.index[k]].coord).abs();
+  }
+}
+
+DoubleSpan MeshBasicOP::getAdjEdgeLengthArray(const VertHandle& vh) const
+{
+  const double* p = vert_slot_len_vec.empty() ? NULL : &vert_slot_len_vec[0];
+  return DoubleSpan(p + vert_adj_vert_csr.offset[vh], p + vert_adj_vert_csr.offset[vh+1]);
+}
+
+EdgeHandleSpan MeshBasicOP::getAdjEdgeArray(const VertHandle& vh) const
+{
+  const EdgeHandle* p = vert_slot_edge_vec.empty() ? NULL : &vert_slot_edge_vec[0];
+  return EdgeHandleSpan(p + vert_adj_vert_csr.offset[vh], p + vert_adj_vert_csr.offset[vh+1]);
 }
 
 EdgeHandle MeshBasicOP::getEdgeHandle(VertHandle vh1, VertHandle vh2) const
 {
   if(vh1 == vh2) return -1;
-  const EdgeHandleArray& eh_vec1 = vert_adj_edge_vec[vh1];
-  const EdgeHandleArray& eh_vec2 = vert_adj_edge_vec[vh2];
-  for(size_t k=0; k<eh_vec1.size(); ++k){
-    const EdgeHandle& eh = eh_vec1[k];
-    if(find(eh_vec2.begin(), eh_vec2.end(), eh) != eh_vec2.end()) return eh;
+  VertHandleSpan adj_verts = vert_adj_vert_csr[vh1];
+  for(size_t k=0; k<adj_verts.size(); ++k){
+    if(adj_verts[k] == vh2) return vert_slot_edge_vec[vert_adj_vert_csr.offset[vh1]+k];
   }
   return -1;
 }
 
 HalfEdgeHandle MeshBasicOP::getHalfEdgeHandle(VertHandle vh1, VertHandle vh2) const{
-  EdgeHandle eh = getEdgeHandle(vh1, vh2);
-  const Edge& e = edge_vec[eh];
-  if(e.he_handle_1 != -1){
-    const HalfEdge& curr_he = he_vec[e.he_handle_1];
-    const HalfEdge& next_he = he_vec[curr_he.next_he_handle];
-    if(curr_he.vert_handle == vh1 && next_he.vert_handle == vh2) return e.he_handle_1;
-  }
-  if(e.he_handle_2 != -1){
-    const HalfEdge& curr_he = he_vec[e.he_handle_2];
-    const HalfEdge& next_he = he_vec[curr_he.next_he_handle];
-    if(curr_he.vert_handle == vh1 && next_he.vert_handle == vh2) return e.he_handle_2;
+  VertHandleSpan adj_verts = vert_adj_vert_csr[vh1];
+  for(size_t k=0; k<adj_verts.size(); ++k){
+    if(adj_verts[k] == vh2) return vert_slot_he_vec[vert_adj_vert_csr.offset[vh1]+k];
   }
   return -1;
 }
@@ -233,7 +348,7 @@ void MeshBasicOP::calVertNormal()
   for(VertHandle vh = 0; vh < vert_vec.size(); ++vh){
     Vert& vert = vert_vec[vh];
     vert.normal.setVec3Ds(0, 0, 0);
-    const vector<FaceHandle>& adj_faces = getAdjFaceArray(vh);
+    FaceHandleSpan adj_faces = getAdjFaceArray(vh);
     for(size_t k=0; k<adj_faces.size(); ++k){
       const Face& face = face_vec[adj_faces[k]];
       vert.normal += face.normal;
@@ -257,7 +372,7 @@ size_t MeshBasicOP::countComponentNum() const
       q.push(vh); visited_flag[vh] = true;
       while(!q.empty()){
         VertHandle _vh = q.front(); q.pop();
-        const vector<VertHandle>& adj_vert = getAdjVertArray(_vh);
+        VertHandleSpan adj_vert = getAdjVertArray(_vh);
         for(size_t k=0; k<adj_vert.size(); ++k){
           if(!visited_flag[adj_vert[k]] ){
             q.push(adj_vert[k]); visited_flag[adj_vert[k]] = true;
@@ -296,12 +411,12 @@ void MeshBasicOP::analysisModel()
     Vert& v1 = (mesh.p_Kernel->vert_vec)[e.vert_handle_1];
     Vert& v2 = (mesh.p_Kernel->vert_vec)[e.vert_handle_2];
 
-    FaceHandleArray& fh_vec = edge_adj_face_vec[eid];
-    if(fh_vec.size() == 1){
+    size_t adj_face_num = edge_adj_face_csr.rowSize(eid);
+    if(adj_face_num == 1){
       Util::SetFlag(e.flag, BOUNDARY_EDGE);
       Util::SetFlag(v1.flag, BOUNDARY_VERT);
       Util::SetFlag(v2.flag, BOUNDARY_VERT);
-    }else if(fh_vec.size() == 0 || fh_vec.size() > 2){
+    }else if(adj_face_num == 0 || adj_face_num > 2){
       manifold = false;
       Util::SetFlag(e.flag, NONMANIFOLD_EDGE);
     }    
@@ -309,15 +424,15 @@ void MeshBasicOP::analysisModel()
   
   for(size_t vid=0; vid<mesh.getVertexNumber(); ++vid){
     Vert& v = (mesh.p_Kernel->vert_vec)[vid];
-    VertHandleArray& vh_vec = vert_adj_vert_vec[vid];    
-    if(vh_vec.size() == 0){
+    size_t adj_vert_num = vert_adj_vert_csr.rowSize(vid);
+    if(adj_vert_num == 0){
       Util::SetFlag(v.flag, ISOLATED_VERT);
-    }else if(vh_vec.size() == 1){
+    }else if(adj_vert_num == 1){
       manifold = false;
       Util::SetFlag(v.flag, NONMANIFOLD_VERT);
     }
 
-    EdgeHandleArray& eh_vec = vert_adj_edge_vec[vid];
+    EdgeHandleSpan eh_vec = vert_adj_edge_csr[vid];
     int bdy_edge_num(0);
     for(size_t k=0; k<eh_vec.size(); ++k){
       if(mesh.isBoundaryEdge(eh_vec[k])) ++bdy_edge_num;        
@@ -379,13 +494,14 @@ void MeshBasicOP::sortAdjacentInfo()
     if(Util::IsSetFlag(v.flag, NONMANIFOLD_VERT)) continue;
     if(Util::IsSetFlag(v.flag, ISOLATED_VERT)) continue;    
     
-    FaceHandleArray fh_vec_bak = vert_adj_face_vec[vid];
-    EdgeHandleArray eh_vec_bak = vert_adj_edge_vec[vid];
-    VertHandleArray vh_vec_bak = vert_adj_vert_vec[vid];
+    FaceHandleArray fh_vec_bak(vert_adj_face_csr[vid].begin(), vert_adj_face_csr[vid].end());
+    EdgeHandleArray eh_vec_bak(vert_adj_edge_csr[vid].begin(), vert_adj_edge_csr[vid].end());
+    VertHandleArray vh_vec_bak(vert_adj_vert_csr[vid].begin(), vert_adj_vert_csr[vid].end());
     
-    FaceHandleArray& adj_faces = vert_adj_face_vec[vid];
-    EdgeHandleArray& adj_edges = vert_adj_edge_vec[vid];
-    VertHandleArray& adj_verts = vert_adj_vert_vec[vid];
+    FaceHandle* adj_faces = vert_adj_face_csr.rowBegin(vid);
+    EdgeHandle* adj_edges = vert_adj_edge_csr.rowBegin(vid);
+    VertHandle* adj_verts = vert_adj_vert_csr.rowBegin(vid);
+    size_t adj_edge_num = eh_vec_bak.size(), adj_vert_num = vh_vec_bak.size();
 
     size_t adj_num = fh_vec_bak.size();
     if(adj_num == 1){
@@ -394,7 +510,7 @@ void MeshBasicOP::sortAdjacentInfo()
       const EdgeHandleArray& eh_vec = f.edge_handle_vec;
       size_t idx = distance(vh_vec.begin(), find(vh_vec.begin(), vh_vec.end(), vid));
       assert(idx != vh_vec.size());
-      assert(adj_edges.size() == 2 && adj_verts.size() == 2);
+      assert(adj_edge_num == 2 && adj_vert_num == 2);
       VertHandle prev_vid = vh_vec[(idx+vh_vec.size()-1)%vh_vec.size()];
       VertHandle next_vid = vh_vec[(idx+1)%vh_vec.size()];
       EdgeHandle prev_eid = eh_vec[(idx+eh_vec.size()-1)%eh_vec.size()];
@@ -473,13 +589,13 @@ void MeshBasicOP::sortAdjacentInfo()
     }    
     if(Util::IsSetFlag(v.flag, BOUNDARY_VERT)){// add the last vertex/edge
       for(size_t k=0; k<vh_vec_bak.size(); ++k){
-        if(find(adj_verts.begin(), adj_verts.end(), vh_vec_bak[k]) == adj_verts.end()){
-          adj_verts[adj_verts.size()-1] = vh_vec_bak[k]; break;
+        if(find(adj_verts, adj_verts+adj_vert_num, vh_vec_bak[k]) == adj_verts+adj_vert_num){
+          adj_verts[adj_vert_num-1] = vh_vec_bak[k]; break;
         }
       }
       for(size_t k=0; k<eh_vec_bak.size(); ++k){
-        if(find(adj_edges.begin(), adj_edges.end(), eh_vec_bak[k]) == adj_edges.end()){
-          adj_edges[adj_edges.size()-1] = eh_vec_bak[k]; break;
+        if(find(adj_edges, adj_edges+adj_edge_num, eh_vec_bak[k]) == adj_edges+adj_edge_num){
+          adj_edges[adj_edge_num-1] = eh_vec_bak[k]; break;
         }
       }
     }
@@ -638,74 +754,11 @@ bool MeshBasicOP::getInnerFaces(const PATH& loop, FaceHandleArray& fh_vec) const
 
 bool MeshBasicOP::getShortestPath(VertHandle start, VertHandle end,
                                   PATH &path, const std::set<EdgeHandle> &edge_set) const{
-  path.clear();
-  if(start == end) path.push_back(start);
-
-#define INIFINITE_DIST (numeric_limits<double>::infinity())
-
-  map<int, double> vert_dist;
-  map<int, double>::iterator iter;
-  map<int, int> prev_vert;
-  prev_vert[end] = -1;
-  CHeap heap;
-  vert_dist[end] = 0.0;
-
-  Node* pNode = new Node;
-  pNode->v = 0.0;
-  pNode->type = end;
-  heap.insert(pNode);
-
-  bool flag = true;
-
-  while(!heap.heapEmpty()){
-    Node* pNode = heap.Remove();
-    VertHandle vh = pNode->type;
-    double vdist = vert_dist[vh];
-    const Coord& vc = mesh.getVertexCoord(vh);
-    const VertHandleArray& adj_vertices = vert_adj_vert_vec[vh];
-    for(size_t i=0; i<adj_vertices.size(); ++i){
-      VertHandle adj_vh = adj_vertices[i];
-      EdgeHandle eh = getEdgeHandle(vh, adj_vh);
-      if(edge_set.find(eh) == edge_set.end()) continue;
-      const Coord& _vc = mesh.getVertexCoord(adj_vertices[i]);
-      double edge_len = (vc-_vc).abs();
-      double adj_vdist = INIFINITE_DIST;
-      if( (iter = vert_dist.find(adj_vh)) != vert_dist.end()) adj_vdist = iter->second;
-      if(vdist + edge_len < adj_vdist){
-        vert_dist[adj_vh] = vdist + edge_len;
-        prev_vert[adj_vh] = vh;
-        int index = heap.heapFind(adj_vh);
-        if(index !=0){
-          heap.a[index]->v = vdist + edge_len;
-          heap.upheap(index);
-        }else{
-          Node* pNewNode = new Node;
-          pNewNode->v = vdist + edge_len;
-          pNewNode->type = adj_vh;
-          heap.insert(pNewNode);
-        }
-      }
-    }
-    delete pNode;
-    if(vh == start) { flag = true; break; }
-  }
-
-  while(!heap.heapEmpty()){
-    Node* pNode = heap.Remove();
-    delete pNode;
-  }
-
-  if(!flag) return false;
-
-  int curr_vid = start;
-  while(prev_vert[curr_vid] != -1){
-    path.push_back(curr_vid);
-    curr_vid = prev_vert[curr_vid];
-  }
-  path.push_back(end);
-  return true;
+  //! one shot search, callers with many queries should keep a MeshPathFinder
+  MeshPathFinder finder(mesh);
+  finder.setAllowedEdges(edge_set);
+  return finder.getShortestPath(start, end, path);
 }
 
-#undef INIFINITE_DIST
 
 }
@@ -18,8 +18,11 @@ namespace meshlib{
 
         void initModel();
 
-        const VertHandleArray& getAdjVertArray(const VertHandle&) const;
-        const FaceHandleArray& getAdjFaceArray(const VertHandle&) const;
+        VertHandleSpan getAdjVertArray(const VertHandle&) const;
+        FaceHandleSpan getAdjFaceArray(const VertHandle&) const;
+        EdgeHandleSpan getAdjEdgeArray(const VertHandle&) const;
+        DoubleSpan getAdjEdgeLengthArray(const VertHandle&) const;
+        int getAdjSlotOffset(const VertHandle& vh) const { return vert_adj_vert_csr.offset[vh]; }
         bool getInnerFaces(const PATH& loop, FaceHandleArray& fh_vec) const;
         EdgeHandle getEdgeHandle(VertHandle vh1, VertHandle vh2) const;
         HalfEdgeHandle getHalfEdgeHandle(VertHandle vh1, VertHandle vh2) const;
@@ -29,6 +32,8 @@ namespace meshlib{
     private:
         void genEdgeInfo();
         void genHalfEdgeDS(); //! only be call for manifold mesh
+        void genVertSlotInfo();
+        void genVertSlotLength();
 
         void genAdjacentInfo();
         void genVertAdjacentInfo();
@@ -54,11 +59,21 @@ namespace meshlib{
         EdgeArray& edge_vec;
         HalfEdgeArray& he_vec;
         
-        std::vector<VertHandleArray > vert_adj_vert_vec;
-        std::vector<FaceHandleArray > vert_adj_face_vec;
-        std::vector<EdgeHandleArray > vert_adj_edge_vec;
-        std::vector<FaceHandleArray > edge_adj_face_vec;
-        std::vector<FaceHandleArray > face_adj_face_vec;
+        //! adjacency lists, one CSR row per element
+        HandleCSR vert_adj_vert_csr;
+        HandleCSR vert_adj_face_csr;
+        HandleCSR vert_adj_edge_csr;
+        HandleCSR edge_adj_face_csr;
+        HandleCSR face_adj_face_csr;
+
+        //! edge and outgoing halfedge of every one-ring slot, aligned with
+        //! the rows of vert_adj_vert_csr
+        EdgeHandleArray vert_slot_edge_vec;
+        HalfEdgeHandleArray vert_slot_he_vec;
+        //! edge length of every one-ring slot
+        DoubleArray vert_slot_len_vec;
+
+        friend class MeshIO;
     };
 }
 #endif
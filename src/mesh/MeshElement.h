@@ -2,6 +2,7 @@
 #define MESHLIB_MESHELEMENT_H_
 
 #include "../common/types.h"
+#include "../util/array_span.h"
 #include <vector>
 
 namespace meshlib{
@@ -18,6 +19,30 @@ namespace meshlib{
   typedef std::vector<HalfEdgeHandle> HalfEdgeHandleArray;
   
   typedef std::vector<VertHandle> PATH;
+
+  typedef ArraySpan<VertHandle> VertHandleSpan;
+  typedef ArraySpan<FaceHandle> FaceHandleSpan;
+  typedef ArraySpan<EdgeHandle> EdgeHandleSpan;
+  typedef ArraySpan<double> DoubleSpan;
+
+  //! compressed sparse rows of handles:
+  //! row i is index[offset[i]] ... index[offset[i+1]-1]
+  class HandleCSR
+  {
+ public:
+    std::vector<int> offset;
+    std::vector<Handle> index;
+
+    void clear() { offset.assign(1, 0); index.clear(); }
+    size_t size() const { return offset.empty() ? 0 : offset.size()-1; }
+    size_t rowSize(size_t i) const { return offset[i+1] - offset[i]; }
+    ArraySpan<Handle> operator[](size_t i) const {
+      const Handle* p = index.empty() ? NULL : &index[0];
+      return ArraySpan<Handle>(p + offset[i], p + offset[i+1]);
+    }
+    Handle* rowBegin(size_t i) { return index.empty() ? NULL : &index[0] + offset[i]; }
+    Handle* rowEnd(size_t i) { return index.empty() ? NULL : &index[0] + offset[i+1]; }
+  };
     
   enum VERTFLAG{
     INITVERT = 0x00000000,
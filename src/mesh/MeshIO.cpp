@@ -1,21 +1,150 @@
 #include "MeshIO.h"
 #include "Mesh.h"
 #include "MeshKernel.h"
+#include "MeshBasicOp.h"
 #include "../util/utility.h"
+#include "../util/mappedfile.h"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
 namespace meshlib{
 
+namespace{
+// hand-written tokenizer helpers of the mapped obj parser
+
+//! files below this size per chunk are not worth a parallel parse
+const size_t OBJ_MIN_CHUNK_SIZE = 1<<20;
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline void skipBlank(const char*& p, const char* end){
+  while(p < end && isBlank(*p)) ++p;
+}
+
+//! skip to the first character of the next line
+inline void skipLine(const char*& p, const char* end){
+  while(p < end && *p != '\n') ++p;
+  if(p < end) ++p;
+}
+
+//! parse a double with the result of strtod (which istream >> uses)
+bool parseDouble(const char*& p, const char* end, double& value){
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  skipBlank(p, end);
+  const char* begin = p;
+  const char* q = p;
+  bool neg = false;
+  if(q < end && (*q == '-' || *q == '+')) { neg = (*q == '-'); ++q; }
+  unsigned long long mantissa = 0;
+  int digits = 0, exp10 = 0;
+  bool any_digit = false;
+  while(q < end && isDigit(*q)){
+    any_digit = true;
+    if(digits < 19) { mantissa = mantissa*10 + (*q - '0'); if(mantissa) ++digits; }
+    else ++exp10;
+    ++q;
+  }
+  if(q < end && *q == '.'){
+    ++q;
+    while(q < end && isDigit(*q)){
+      any_digit = true;
+      if(digits < 19) { mantissa = mantissa*10 + (*q - '0'); --exp10; if(mantissa) ++digits; }
+      ++q;
+    }
+  }
+  if(any_digit && q < end && (*q == 'e' || *q == 'E')){
+    const char* r = q+1;
+    bool exp_neg = false;
+    if(r < end && (*r == '-' || *r == '+')) { exp_neg = (*r == '-'); ++r; }
+    if(r < end && isDigit(*r)){
+      int e = 0;
+      while(r < end && isDigit(*r)) { if(e < 100000) e = e*10 + (*r - '0'); ++r; }
+      exp10 += exp_neg ? -e : e;
+      q = r;
+    }
+  }
+  if(any_digit && digits < 19 && mantissa <= (1ULL<<53) && exp10 >= -22 && exp10 <= 22){
+    //! both operands are exact, so the single rounding matches strtod
+    double v = (double)mantissa;
+    v = (exp10 < 0) ? v / pow10[-exp10] : v * pow10[exp10];
+    value = neg ? -v : v;
+    p = q;
+    return true;
+  }
+  //! long mantissa, large exponent, inf/nan ... leave it to strtod
+  const char* tok_end = begin;
+  while(tok_end < end && !isBlank(*tok_end) && *tok_end != '\n') ++tok_end;
+  std::string token(begin, tok_end);
+  char* conv_end = NULL;
+  value = strtod(token.c_str(), &conv_end);
+  if(conv_end == token.c_str()) return false;
+  p = begin + (conv_end - token.c_str());
+  return true;
+}
+
+//! parse the vertex index of a face corner "v", "v/t", "v/t/n" or "v//n"
+inline bool parseFaceCorner(const char*& p, const char* end, int& v){
+  if(p >= end || !isDigit(*p)) return false;
+  v = 0;
+  while(p < end && isDigit(*p)) { v = v*10 + (*p - '0'); ++p; }
+  while(p < end && !isBlank(*p) && *p != '\n') ++p; // skip texture/normal index
+  return true;
+}
+
+//! parse the obj lines in [p, end) and append the vertices and faces
+void parseObjRange(const char* p, const char* end, VertArray& vert_vec, FaceArray& face_vec){
+  while(p < end){
+    skipBlank(p, end);
+    if(p == end) break;
+    if(*p == 'v' && p+1 < end && isBlank(p[1])){ /* v */
+      ++p;
+      vert_vec.push_back(Vert());
+      Coord3D& coord = vert_vec.back().coord;
+      for(size_t k=0; k<3; ++k){
+        if(!parseDouble(p, end, coord[k])) break;
+      }
+    }else if(*p == 'f' && p+1 < end && isBlank(p[1])){ /* f */
+      ++p;
+      face_vec.push_back(Face());
+      VertHandleArray& vh_vec = face_vec.back().vert_handle_vec;
+      while(p < end){
+        skipBlank(p, end);
+        if(p == end || *p == '\n') break;
+        if(*p == '\\'){ // continue on the next line
+          const char* q = p+1;
+          skipBlank(q, end);
+          if(q < end && *q == '\n') { p = q+1; continue; }
+        }
+        int v;
+        if(parseFaceCorner(p, end, v)) vh_vec.push_back(v-1);
+        else while(p < end && !isBlank(*p) && *p != '\n') ++p;
+      }
+    }
+    //! vt, vn, comments, groups and materials are skipped
+    skipLine(p, end);
+  }
+}
+
+} // end anonymous namespace
+
 MeshIO::MeshIO(Mesh& mesh) : m_mesh(mesh){}
 MeshIO::~MeshIO(){}
 
 
-bool MeshIO::LoadModel(const std::string& filename)
+bool MeshIO::LoadModel(const std::string& filename, int load_flag)
 {
   // Resolve file name
   std::string file_path, file_title, file_ext;
@@ -37,7 +166,9 @@ bool MeshIO::LoadModel(const std::string& filename)
   }else if(file_ext == ".off"){
     bOpenFlag = OpenOffFile(filename);
   }else if(file_ext == ".obj"){
-    bOpenFlag = OpenObjFile(filename);
+    if(Util::IsSetFlag(load_flag, (int)LOAD_PARALLEL)) bOpenFlag = OpenObjFileMapped(filename, true);
+    else if(Util::IsSetFlag(load_flag, (int)LOAD_MMAP)) bOpenFlag = OpenObjFileMapped(filename, false);
+    else bOpenFlag = OpenObjFile(filename);
   }else{
     bOpenFlag = false;
   }
@@ -256,6 +387,80 @@ bool MeshIO::OpenObjFile(const std::string& filename)
   
   return true;
 }
+bool MeshIO::OpenObjFileMapped(const std::string& filename, bool parallel)
+{
+  MappedFile file;
+  if(!file.open(filename)) return false;
+
+  std::vector<Vert>& vert_vec = m_mesh.p_Kernel->getVertArray();
+  std::vector<Face>& face_vec = m_mesh.p_Kernel->getFaceArray();
+  vert_vec.clear(); face_vec.clear();
+
+  const char* data = file.data();
+  const char* end = data + file.size();
+  size_t chunk_num = 1;
+#ifdef _OPENMP
+  if(parallel && file.size() > OBJ_MIN_CHUNK_SIZE){
+    chunk_num = 4*omp_get_max_threads();
+    chunk_num = std::min(chunk_num, file.size()/OBJ_MIN_CHUNK_SIZE);
+  }
+#endif
+  if(chunk_num <= 1){
+    parseObjRange(data, end, vert_vec, face_vec);
+  }else{
+    //! split at line boundaries, a continued face line stays in one chunk
+    std::vector<const char*> bound(chunk_num+1, end);
+    bound[0] = data;
+    for(size_t k=1; k<chunk_num; ++k){
+      const char* p = std::max(data + file.size()/chunk_num*k, bound[k-1]);
+      while(p < end){
+        const char* eol = (const char*)memchr(p, '\n', end-p);
+        if(eol == NULL) { p = end; break; }
+        const char* q = eol;
+        while(q > data && isBlank(q[-1])) --q;
+        p = eol+1;
+        if(q == data || q[-1] != '\\') break;
+      }
+      bound[k] = p;
+    }
+
+    std::vector<VertArray> chunk_verts(chunk_num);
+    std::vector<FaceArray> chunk_faces(chunk_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for(int k=0; k<(int)chunk_num; ++k){
+      parseObjRange(bound[k], bound[k+1], chunk_verts[k], chunk_faces[k]);
+    }
+
+    //! prefix sum of the chunk counts gives each chunk's place in the arrays
+    std::vector<size_t> vert_offset(chunk_num+1, 0), face_offset(chunk_num+1, 0);
+    for(size_t k=0; k<chunk_num; ++k){
+      vert_offset[k+1] = vert_offset[k] + chunk_verts[k].size();
+      face_offset[k+1] = face_offset[k] + chunk_faces[k].size();
+    }
+    vert_vec.resize(vert_offset[chunk_num]);
+    face_vec.resize(face_offset[chunk_num]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for(int k=0; k<(int)chunk_num; ++k){
+      std::copy(chunk_verts[k].begin(), chunk_verts[k].end(), vert_vec.begin()+vert_offset[k]);
+      FaceArray& faces = chunk_faces[k];
+      for(size_t i=0; i<faces.size(); ++i){
+        Face& face = face_vec[face_offset[k]+i];
+        face.vert_handle_vec.swap(faces[i].vert_handle_vec);
+      }
+      Util::FreeVector(chunk_verts[k]);
+      Util::FreeVector(faces);
+    }
+  }
+
+  m_mesh.p_Info->m_nVertices = vert_vec.size();
+  m_mesh.p_Info->m_nFaces = face_vec.size();
+  return true;
+}
+
 bool MeshIO::SaveObjFile(const std::string& filename) const
 {
   std::ofstream file(filename.c_str());
@@ -293,4 +498,267 @@ bool MeshIO::SaveObjFile(const std::string& filename) const
   file.close();
   return true;
 }
+
+namespace{
+// .mshb layout: header, then every section is a 64 bit element count
+// followed by the raw elements, padded to 8 bytes so it can be viewed in place
+const char MSHB_MAGIC[4] = {'M', 'S', 'H', 'B'};
+const unsigned int MSHB_VERSION = 3;
+
+struct MshbHeader{
+  char magic[4];
+  unsigned int version;
+  unsigned long long source_hash;
+};
+
+template <class T>
+void writeSection(std::ofstream& fout, const std::vector<T>& vec){
+  static const char pad[8] = {0};
+  unsigned long long n = vec.size();
+  fout.write((const char*)&n, sizeof(n));
+  if(n) fout.write((const char*)&vec[0], n*sizeof(T));
+  size_t bytes = n*sizeof(T);
+  if(bytes%8) fout.write(pad, 8-bytes%8);
+}
+
+template <class T>
+bool readSection(const char*& p, const char* end, std::vector<T>& vec){
+  unsigned long long n;
+  if((size_t)(end-p) < sizeof(n)) return false;
+  memcpy(&n, p, sizeof(n)); p += sizeof(n);
+  //! n is read from the file, check it before n*sizeof(T) can overflow
+  if(n > (size_t)(end-p)/sizeof(T)) return false;
+  size_t bytes = n*sizeof(T);
+  vec.resize(n);
+  if(n) memcpy((char*)&vec[0], p, bytes);
+  p += (bytes+7)/8*8;
+  return p <= end;
+}
+
+//! nested arrays are stored as offset + index arrays
+void writeNested(std::ofstream& fout, const std::vector<IndexArray>& nested){
+  IndexArray offset(1, 0), index;
+  for(size_t i=0; i<nested.size(); ++i){
+    index.insert(index.end(), nested[i].begin(), nested[i].end());
+    offset.push_back(index.size());
+  }
+  writeSection(fout, offset);
+  writeSection(fout, index);
+}
+
+void writeCSR(std::ofstream& fout, const HandleCSR& csr){
+  writeSection(fout, csr.offset);
+  writeSection(fout, csr.index);
+}
+
+bool readCSR(const char*& p, const char* end, HandleCSR& csr){
+  if(!readSection(p, end, csr.offset) || !readSection(p, end, csr.index)) return false;
+  return !csr.offset.empty() && csr.offset.back() == (int)csr.index.size();
+}
+
+bool readNested(const char*& p, const char* end, std::vector<IndexArray>& nested){
+  IndexArray offset, index;
+  if(!readSection(p, end, offset) || !readSection(p, end, index)) return false;
+  if(offset.empty() || offset.back() != (int)index.size()) return false;
+  nested.resize(offset.size()-1);
+  for(size_t i=0; i<nested.size(); ++i)
+    nested[i].assign(index.begin()+offset[i], index.begin()+offset[i+1]);
+  return true;
+}
+} // end anonymous namespace
+
+std::string MeshIO::CacheFileName(const std::string& filename)
+{
+  std::string file_path, file_title, file_ext;
+  Util::ResolveFileName(filename, file_path, file_title, file_ext);
+  return file_path + file_title + ".mshb";
+}
+
+bool MeshIO::HashSourceFile(const std::string& filename, unsigned long long& hash)
+{
+  MappedFile file;
+  if(!file.open(filename)) return false;
+  unsigned long long size = file.size();
+  hash = Util::Hash64(&size, sizeof(size));
+  hash = Util::Hash64(file.data(), file.size(), hash);
+  return true;
+}
+
+bool MeshIO::LoadCache(const std::string& cache_name, unsigned long long source_hash)
+{
+  MappedFile file;
+  if(!file.open(cache_name)) return false;
+  const char* p = file.data();
+  const char* end = p + file.size();
+  MshbHeader header;
+  if(file.size() < sizeof(header)) return false;
+  memcpy(&header, p, sizeof(header)); p += sizeof(header);
+  if(memcmp(header.magic, MSHB_MAGIC, 4) != 0 || header.version != MSHB_VERSION ||
+     header.source_hash != source_hash){
+    printf("Cache %s is stale\n", cache_name.c_str());
+    return false;
+  }
+
+  std::vector<Coord3D> coord, vert_normal, face_normal;
+  IntArray vert_flag, vert_he, face_flag, edge_data, edge_flag, he_data;
+  std::vector<IndexArray> face_vh, face_eh, face_hh;
+  DoubleArray info_real;
+  std::vector<unsigned long long> info_int;
+  MeshBasicOP& basic_op = *m_mesh.p_BasicOP;
+  bool ok = readSection(p, end, coord) && readSection(p, end, vert_normal) &&
+      readSection(p, end, vert_flag) && readSection(p, end, vert_he) &&
+      readNested(p, end, face_vh) && readNested(p, end, face_eh) && readNested(p, end, face_hh) &&
+      readSection(p, end, face_normal) && readSection(p, end, face_flag) &&
+      readSection(p, end, edge_data) && readSection(p, end, edge_flag) &&
+      readSection(p, end, he_data) &&
+      readCSR(p, end, basic_op.vert_adj_vert_csr) && readCSR(p, end, basic_op.vert_adj_face_csr) &&
+      readCSR(p, end, basic_op.vert_adj_edge_csr) && readCSR(p, end, basic_op.edge_adj_face_csr) &&
+      readCSR(p, end, basic_op.face_adj_face_csr) &&
+      readSection(p, end, basic_op.vert_slot_len_vec) &&
+      readSection(p, end, info_real) && readSection(p, end, info_int);
+  if(!ok || info_real.size() != 14 || info_int.size() != 4 ||
+     basic_op.vert_slot_len_vec.size() != basic_op.vert_adj_vert_csr.index.size()){
+    cerr << "Broken mesh cache " << cache_name << endl;
+    return false;
+  }
+
+  VertArray& vert_vec = m_mesh.p_Kernel->getVertArray();
+  FaceArray& face_vec = m_mesh.p_Kernel->getFaceArray();
+  EdgeArray& edge_vec = m_mesh.p_Kernel->getEdgeArray();
+  HalfEdgeArray& he_vec = m_mesh.p_Kernel->getHEArray();
+  vert_vec.resize(coord.size());
+  for(size_t i=0; i<vert_vec.size(); ++i){
+    Vert& v = vert_vec[i];
+    v.coord = coord[i]; v.normal = vert_normal[i];
+    v.flag = (VERTFLAG)vert_flag[i]; v.he_handle = vert_he[i];
+  }
+  face_vec.resize(face_vh.size());
+  for(size_t i=0; i<face_vec.size(); ++i){
+    Face& f = face_vec[i];
+    f.vert_handle_vec.swap(face_vh[i]);
+    f.edge_handle_vec.swap(face_eh[i]);
+    f.he_handle_vec.swap(face_hh[i]);
+    f.normal = face_normal[i]; f.flag = (FACEFLAG)face_flag[i];
+  }
+  edge_vec.resize(edge_flag.size());
+  for(size_t i=0; i<edge_vec.size(); ++i){
+    Edge& e = edge_vec[i];
+    e.vert_handle_1 = edge_data[4*i]; e.vert_handle_2 = edge_data[4*i+1];
+    e.he_handle_1 = edge_data[4*i+2]; e.he_handle_2 = edge_data[4*i+3];
+    e.flag = (EDGEFLAG)edge_flag[i];
+  }
+  he_vec.resize(he_data.size()/6);
+  for(size_t i=0; i<he_vec.size(); ++i){
+    const int* h = &he_data[6*i];
+    he_vec[i] = HalfEdge(h[0], h[1], h[2], h[3], h[4], h[5]);
+  }
+
+  //! slot tables are cheap to derive from the cached adjacency
+  basic_op.genVertSlotInfo();
+
+  MeshInfo& info = *m_mesh.p_Info;
+  for(size_t k=0; k<3; ++k){
+    info.m_BoundingBox.box_min[k] = info_real[k];
+    info.m_BoundingBox.box_max[k] = info_real[3+k];
+    info.m_BoundingBox.box_dim[k] = info_real[6+k];
+    info.m_BoundingSphere.center[k] = info_real[9+k];
+  }
+  info.m_BoundingSphere.radius = info_real[12];
+  info.m_AvgEdgeLength = info_real[13];
+  info.m_nVertices = info_int[0];
+  info.m_nFaces = info_int[1];
+  info.m_nComponents = info_int[2];
+  info.flag = (MESHFLAG)info_int[3];
+
+  std::string file_path, file_title, file_ext;
+  Util::ResolveFileName(cache_name, file_path, file_title, file_ext);
+  printf("Load Cache %s... Success\n", (file_title+file_ext).c_str());
+  printf("#Vertex = %d, #Face = %d\n\n", (int)info.m_nVertices, (int)info.m_nFaces);
+  return true;
+}
+
+bool MeshIO::StoreCache(const std::string& cache_name, unsigned long long source_hash) const
+{
+  std::ofstream fout(cache_name.c_str(), std::ios::binary);
+  if(!fout) return false;
+
+  const VertArray& vert_vec = m_mesh.p_Kernel->getVertArray();
+  const FaceArray& face_vec = m_mesh.p_Kernel->getFaceArray();
+  const EdgeArray& edge_vec = m_mesh.p_Kernel->getEdgeArray();
+  const HalfEdgeArray& he_vec = m_mesh.p_Kernel->getHEArray();
+  const MeshBasicOP& basic_op = *m_mesh.p_BasicOP;
+  const MeshInfo& info = *m_mesh.p_Info;
+
+  MshbHeader header;
+  memcpy(header.magic, MSHB_MAGIC, 4);
+  header.version = MSHB_VERSION;
+  header.source_hash = source_hash;
+  fout.write((const char*)&header, sizeof(header));
+
+  std::vector<Coord3D> coord(vert_vec.size()), vert_normal(vert_vec.size());
+  IntArray vert_flag(vert_vec.size()), vert_he(vert_vec.size());
+  for(size_t i=0; i<vert_vec.size(); ++i){
+    coord[i] = vert_vec[i].coord; vert_normal[i] = vert_vec[i].normal;
+    vert_flag[i] = vert_vec[i].flag; vert_he[i] = vert_vec[i].he_handle;
+  }
+  writeSection(fout, coord); writeSection(fout, vert_normal);
+  writeSection(fout, vert_flag); writeSection(fout, vert_he);
+
+  std::vector<IndexArray> face_vh(face_vec.size()), face_eh(face_vec.size()), face_hh(face_vec.size());
+  std::vector<Coord3D> face_normal(face_vec.size());
+  IntArray face_flag(face_vec.size());
+  for(size_t i=0; i<face_vec.size(); ++i){
+    face_vh[i] = face_vec[i].vert_handle_vec;
+    face_eh[i] = face_vec[i].edge_handle_vec;
+    face_hh[i] = face_vec[i].he_handle_vec;
+    face_normal[i] = face_vec[i].normal; face_flag[i] = face_vec[i].flag;
+  }
+  writeNested(fout, face_vh); writeNested(fout, face_eh); writeNested(fout, face_hh);
+  writeSection(fout, face_normal); writeSection(fout, face_flag);
+
+  IntArray edge_data(4*edge_vec.size()), edge_flag(edge_vec.size());
+  for(size_t i=0; i<edge_vec.size(); ++i){
+    const Edge& e = edge_vec[i];
+    edge_data[4*i] = e.vert_handle_1; edge_data[4*i+1] = e.vert_handle_2;
+    edge_data[4*i+2] = e.he_handle_1; edge_data[4*i+3] = e.he_handle_2;
+    edge_flag[i] = e.flag;
+  }
+  writeSection(fout, edge_data); writeSection(fout, edge_flag);
+
+  IntArray he_data(6*he_vec.size());
+  for(size_t i=0; i<he_vec.size(); ++i){
+    const HalfEdge& he = he_vec[i];
+    int* h = &he_data[6*i];
+    h[0] = he.vert_handle; h[1] = he.edge_handle; h[2] = he.face_handle;
+    h[3] = he.prev_he_handle; h[4] = he.next_he_handle; h[5] = he.oppo_he_handle;
+  }
+  writeSection(fout, he_data);
+
+  writeCSR(fout, basic_op.vert_adj_vert_csr);
+  writeCSR(fout, basic_op.vert_adj_face_csr);
+  writeCSR(fout, basic_op.vert_adj_edge_csr);
+  writeCSR(fout, basic_op.edge_adj_face_csr);
+  writeCSR(fout, basic_op.face_adj_face_csr);
+  writeSection(fout, basic_op.vert_slot_len_vec);
+
+  DoubleArray info_real(14);
+  for(size_t k=0; k<3; ++k){
+    info_real[k] = info.m_BoundingBox.box_min[k];
+    info_real[3+k] = info.m_BoundingBox.box_max[k];
+    info_real[6+k] = info.m_BoundingBox.box_dim[k];
+    info_real[9+k] = info.m_BoundingSphere.center[k];
+  }
+  info_real[12] = info.m_BoundingSphere.radius;
+  info_real[13] = info.m_AvgEdgeLength;
+  std::vector<unsigned long long> info_int(4);
+  info_int[0] = info.m_nVertices; info_int[1] = info.m_nFaces;
+  info_int[2] = info.m_nComponents; info_int[3] = info.flag;
+  writeSection(fout, info_real); writeSection(fout, info_int);
+
+  if(!fout){
+    fout.close(); remove(cache_name.c_str());
+    return false;
+  }
+  return true;
+}
 }
@@ -16,9 +16,15 @@ namespace meshlib{
         ~MeshIO();
 
         // General I/O functions
-        bool LoadModel(const std::string& filename);
+        bool LoadModel(const std::string& filename, int load_flag);
         bool StoreModel(const std::string& filename) const;
 
+        // .mshb binary topology cache functions
+        static std::string CacheFileName(const std::string& filename);
+        static bool HashSourceFile(const std::string& filename, unsigned long long& hash);
+        bool LoadCache(const std::string& cache_name, unsigned long long source_hash);
+        bool StoreCache(const std::string& cache_name, unsigned long long source_hash) const;
+
     private:
         // .tm file I/O functions
         bool OpenTmFile(const std::string& filename);
@@ -34,6 +40,7 @@ namespace meshlib{
 	
         // .obj file I/O functions
         bool OpenObjFile(const std::string& filename);
+        bool OpenObjFileMapped(const std::string& filename, bool parallel);
         bool SaveObjFile(const std::string& filename) const;
     };
 } // 
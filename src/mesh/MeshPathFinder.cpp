@@ -0,0 +1,233 @@
+#include "MeshPathFinder.h"
+#include "Mesh.h"
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+namespace meshlib{
+
+MeshPathFinder::MeshPathFinder(const Mesh& _mesh, int _search_mode) :
+    mesh(_mesh),
+    search_mode(_search_mode),
+    allowed_edge_mask((_mesh.getEdgeNumber()+31)/32, 0),
+    curr_stamp(0),
+    settled_num(0)
+{
+  //! the start side front is only needed by the bidirectional search
+  front[0].resize(_mesh.getVertexNumber());
+}
+MeshPathFinder::~MeshPathFinder(){}
+
+void MeshPathFinder::setAllowedEdges(const set<EdgeHandle>& edge_set)
+{
+  clearAllowedEdges();
+  for(set<EdgeHandle>::const_iterator it = edge_set.begin(); it != edge_set.end(); ++it)
+    addAllowedEdge(*it);
+}
+
+void MeshPathFinder::addAllowedEdge(EdgeHandle eh)
+{
+  if(eh < 0 || isAllowedEdge(eh)) return;
+  allowed_edge_mask[eh >> 5] |= 1u << (eh & 31);
+  allowed_edge_vec.push_back(eh);
+}
+
+void MeshPathFinder::setAllowedFaces(const FaceHandleArray& fh_vec)
+{
+  clearAllowedEdges();
+  addAllowedFaces(fh_vec);
+}
+
+void MeshPathFinder::addAllowedFaces(const FaceHandleArray& fh_vec)
+{
+  for(size_t i=0; i<fh_vec.size(); ++i){
+    const EdgeHandleArray& eh_vec = mesh.getFaceEdges(fh_vec[i]);
+    for(size_t k=0; k<eh_vec.size(); ++k) addAllowedEdge(eh_vec[k]);
+  }
+}
+
+void MeshPathFinder::addAllowedPath(const PATH& path)
+{
+  for(size_t k=0; k+1<path.size(); ++k)
+    addAllowedEdge(mesh.getEdgeHandle(path[k], path[k+1]));
+}
+
+void MeshPathFinder::clearAllowedEdges()
+{
+  //! only the words that were set are touched
+  for(size_t k=0; k<allowed_edge_vec.size(); ++k)
+    allowed_edge_mask[allowed_edge_vec[k] >> 5] = 0;
+  allowed_edge_vec.clear();
+}
+
+void MeshPathFinder::SearchFront::resize(size_t n)
+{
+  dist.resize(n);
+  prev.resize(n);
+  stamp.assign(n, 0);
+  heap.reserve(n);
+}
+
+void MeshPathFinder::newSearch()
+{
+  front[0].heap.clear();
+  front[1].heap.clear();
+  settled_num = 0;
+  if(++curr_stamp == 0){
+    fill(front[0].stamp.begin(), front[0].stamp.end(), 0);
+    fill(front[1].stamp.begin(), front[1].stamp.end(), 0);
+    curr_stamp = 1;
+  }
+}
+
+void MeshPathFinder::seed(SearchFront& f, VertHandle vh)
+{
+  f.stamp[vh] = curr_stamp;
+  f.dist[vh] = 0.0;
+  f.prev[vh] = -1;
+  f.heap.push(vh, 0.0);
+}
+
+bool MeshPathFinder::getShortestPath(VertHandle start, VertHandle end, PATH& path)
+{
+  path.clear();
+  newSearch();
+  switch(search_mode){
+    case SEARCH_ASTAR: return searchAStar(start, end, path);
+    case SEARCH_BIDIRECTIONAL: return searchBidirectional(start, end, path);
+    default: return searchDijkstra(start, end, path);
+  }
+}
+
+bool MeshPathFinder::searchDijkstra(VertHandle start, VertHandle end, PATH& path)
+{
+  SearchFront& f = front[0];
+  seed(f, end);
+
+  bool found = false;
+  while(!f.heap.empty()){
+    VertHandle vh = f.heap.pop();
+    ++settled_num;
+    double vdist = f.dist[vh];
+    const Coord& vc = mesh.getVertexCoord(vh);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vh);
+    EdgeHandleSpan adj_edges = mesh.getAdjEdges(vh);
+    for(size_t i=0; i<adj_vertices.size(); ++i){
+      if(!isAllowedEdge(adj_edges[i])) continue;
+      VertHandle adj_vh = adj_vertices[i];
+      const Coord& _vc = mesh.getVertexCoord(adj_vh);
+      double edge_len = (vc-_vc).abs();
+      if(!isReached(f, adj_vh) || vdist + edge_len < f.dist[adj_vh]){
+        f.stamp[adj_vh] = curr_stamp;
+        f.dist[adj_vh] = vdist + edge_len;
+        f.prev[adj_vh] = vh;
+        f.heap.pushOrDecrease(adj_vh, vdist + edge_len);
+      }
+    }
+    if(vh == start) { found = true; break; }
+  }
+  if(!found) return false;
+
+  for(VertHandle curr_vid = start; curr_vid != end; curr_vid = f.prev[curr_vid])
+    path.push_back(curr_vid);
+  path.push_back(end);
+  return true;
+}
+
+bool MeshPathFinder::searchAStar(VertHandle start, VertHandle end, PATH& path)
+{
+  //! the straight line distance to start never overestimates and is
+  //! consistent with the edge lengths, so a popped vertex is final
+  SearchFront& f = front[0];
+  const Coord& goal = mesh.getVertexCoord(start);
+  seed(f, end);
+
+  bool found = false;
+  while(!f.heap.empty()){
+    VertHandle vh = f.heap.pop();
+    ++settled_num;
+    if(vh == start) { found = true; break; }
+    double vdist = f.dist[vh];
+    const Coord& vc = mesh.getVertexCoord(vh);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vh);
+    EdgeHandleSpan adj_edges = mesh.getAdjEdges(vh);
+    for(size_t i=0; i<adj_vertices.size(); ++i){
+      if(!isAllowedEdge(adj_edges[i])) continue;
+      VertHandle adj_vh = adj_vertices[i];
+      if(isSettled(f, adj_vh)) continue;
+      const Coord& _vc = mesh.getVertexCoord(adj_vh);
+      double new_dist = vdist + (vc-_vc).abs();
+      if(!isReached(f, adj_vh) || new_dist < f.dist[adj_vh]){
+        f.stamp[adj_vh] = curr_stamp;
+        f.dist[adj_vh] = new_dist;
+        f.prev[adj_vh] = vh;
+        f.heap.pushOrDecrease(adj_vh, new_dist + (goal-_vc).abs());
+      }
+    }
+  }
+  if(!found) return false;
+
+  for(VertHandle curr_vid = start; curr_vid != end; curr_vid = f.prev[curr_vid])
+    path.push_back(curr_vid);
+  path.push_back(end);
+  return true;
+}
+
+bool MeshPathFinder::searchBidirectional(VertHandle start, VertHandle end, PATH& path)
+{
+  if(front[1].stamp.size() != front[0].stamp.size())
+    front[1].resize(front[0].stamp.size());
+  if(start == end) { path.push_back(start); return true; }
+
+  seed(front[0], end);
+  seed(front[1], start);
+
+  //! best path found so far runs over the edge (meet_vh[0], meet_vh[1]),
+  //! meet_vh[k] being reached by front k
+  double best_dist = numeric_limits<double>::max();
+  VertHandle meet_vh[2] = {-1, -1};
+
+  while(!front[0].heap.empty() && !front[1].heap.empty()){
+    if(front[0].heap.topKey() + front[1].heap.topKey() >= best_dist) break;
+    //! expand the smaller front, the end side on ties
+    int side = front[0].heap.topKey() <= front[1].heap.topKey() ? 0 : 1;
+    SearchFront& f = front[side];
+    const SearchFront& g = front[1-side];
+
+    VertHandle vh = f.heap.pop();
+    ++settled_num;
+    double vdist = f.dist[vh];
+    const Coord& vc = mesh.getVertexCoord(vh);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vh);
+    EdgeHandleSpan adj_edges = mesh.getAdjEdges(vh);
+    for(size_t i=0; i<adj_vertices.size(); ++i){
+      if(!isAllowedEdge(adj_edges[i])) continue;
+      VertHandle adj_vh = adj_vertices[i];
+      const Coord& _vc = mesh.getVertexCoord(adj_vh);
+      double new_dist = vdist + (vc-_vc).abs();
+      if(!isSettled(f, adj_vh) &&
+         (!isReached(f, adj_vh) || new_dist < f.dist[adj_vh])){
+        f.stamp[adj_vh] = curr_stamp;
+        f.dist[adj_vh] = new_dist;
+        f.prev[adj_vh] = vh;
+        f.heap.pushOrDecrease(adj_vh, new_dist);
+      }
+      if(isReached(g, adj_vh) && new_dist + g.dist[adj_vh] < best_dist){
+        best_dist = new_dist + g.dist[adj_vh];
+        meet_vh[side] = vh;
+        meet_vh[1-side] = adj_vh;
+      }
+    }
+  }
+  if(meet_vh[0] == -1) return false;
+
+  for(VertHandle curr_vid = meet_vh[1]; curr_vid != -1; curr_vid = front[1].prev[curr_vid])
+    path.push_back(curr_vid);
+  reverse(path.begin(), path.end());
+  for(VertHandle curr_vid = meet_vh[0]; curr_vid != -1; curr_vid = front[0].prev[curr_vid])
+    path.push_back(curr_vid);
+  return true;
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef MESHLIB_MESHPATHFINDER_H_
+#define MESHLIB_MESHPATHFINDER_H_
+
+#include <vector>
+#include <set>
+#include "MeshElement.h"
+#include "../util/indexed_heap.h"
+
+namespace meshlib{
+
+  class Mesh;
+
+  //! search strategies of MeshPathFinder
+  enum PATHSEARCHMODE{
+    SEARCH_DIJKSTRA = 0,     // exhaustive Dijkstra from the end vertex
+    SEARCH_ASTAR = 1,        // A* towards the start vertex, euclidean heuristic
+    SEARCH_BIDIRECTIONAL = 2 // Dijkstra from both ends until the fronts meet
+  };
+
+  /*
+    Shortest edge path search over a subset of the mesh edges.
+    All scratch data is dense and owned by the finder: distances and
+    predecessors are per vertex and reset lazily through a generation
+    stamp, the allowed edges are a bitmask. A finder reads the mesh only,
+    so several finders (e.g. one per thread) can share one mesh.
+
+    All modes return a path of minimal length. When several paths have
+    the same length the modes may pick different ones, but each mode
+    picks the same one for the same input.
+  */
+  class MeshPathFinder
+  {
+ public:
+    MeshPathFinder(const Mesh& mesh, int search_mode = SEARCH_DIJKSTRA);
+    ~MeshPathFinder();
+
+    void setSearchMode(int mode) { search_mode = mode; }
+    int getSearchMode() const { return search_mode; }
+
+    //! restrict the search to the given edges, replacing the previous ones
+    void setAllowedEdges(const std::set<EdgeHandle>& edge_set);
+    void addAllowedEdge(EdgeHandle eh);
+    //! allow the edges of a face set, e.g. the faces of a patch
+    void setAllowedFaces(const FaceHandleArray& fh_vec);
+    void addAllowedFaces(const FaceHandleArray& fh_vec);
+    //! allow the edges between consecutive vertices of a path
+    void addAllowedPath(const PATH& path);
+    void clearAllowedEdges();
+    bool isAllowedEdge(EdgeHandle eh) const {
+      return (allowed_edge_mask[eh >> 5] >> (eh & 31)) & 1u;
+    }
+
+    /*
+      shortest path from start to end over the allowed edges, weighted by
+      edge length, using the current search mode.
+      @return false if start cannot be reached
+    */
+    bool getShortestPath(VertHandle start, VertHandle end, PATH& path);
+
+    //! number of vertices settled by the last search
+    size_t getSettledNumber() const { return settled_num; }
+
+ private:
+    //! per direction search state
+    struct SearchFront{
+      std::vector<double> dist;
+      std::vector<VertHandle> prev;
+      std::vector<unsigned int> stamp;
+      IndexedHeap<double, 2> heap;
+      void resize(size_t n);
+    };
+
+    void newSearch();
+    bool isReached(const SearchFront& front, VertHandle vh) const {
+      return front.stamp[vh] == curr_stamp;
+    }
+    //! reached and already popped from the heap
+    bool isSettled(const SearchFront& front, VertHandle vh) const {
+      return isReached(front, vh) && !front.heap.contains(vh);
+    }
+    void seed(SearchFront& front, VertHandle vh);
+
+    bool searchDijkstra(VertHandle start, VertHandle end, PATH& path);
+    bool searchAStar(VertHandle start, VertHandle end, PATH& path);
+    bool searchBidirectional(VertHandle start, VertHandle end, PATH& path);
+
+ private:
+    const Mesh& mesh;
+    int search_mode;
+
+    std::vector<unsigned int> allowed_edge_mask;
+    EdgeHandleArray allowed_edge_vec;
+
+    //! front 0 grows from the end vertex, front 1 from the start vertex
+    SearchFront front[2];
+    unsigned int curr_stamp;
+    size_t settled_num;
+  };
+}
+#endif
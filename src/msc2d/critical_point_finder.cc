@@ -1,7 +1,10 @@
 #include "critical_point_finder.h"
 #include "mscomplex.h"
 #include "../mesh/Mesh.h"
-#include <queue>
+#include "../util/radix_sort.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace msc2d{
 using namespace std;
@@ -13,83 +16,140 @@ CPFinder::CPFinder(MSComplex2D& _msc, bool _rm_boundary_saddle):
 CPFinder::~CPFinder(){}
 
 bool CPFinder::resolveFlatRegion(){
-  size_t vert_num = mesh.getVertexNumber();  
+  //! a flat region collects the vertices reachable from its first vertex
+  //! through values within LARGE_ZERO_EPSILON of that vertex. all vertices
+  //! of a region are keyed by the region's value and listed in breadth
+  //! first order, so the stable sort ranks them in that order
+  size_t vert_num = mesh.getVertexNumber();
   vector<bool> visited_flag(vert_num, false);
+  vector< pair<unsigned long long, int> > key_vec(vert_num);
 
-  msc.vert_priority_mp.clear();
+  size_t head = 0, tail = 0;
   for(size_t vid = 0; vid < vert_num; ++vid){
-    if(visited_flag[vid] == false){
-      queue<int> q;
-      q.push(vid);
-      visited_flag[vid] = true;
-
-      int priority = -1;
-      while(!q.empty()){
-        int v = q.front(); q.pop();
-
-        msc.vert_priority_mp[v] = priority++;
-
-        const VertHandleArray& adj_vertices = mesh.getAdjVertices(v);
-        for(size_t k=0; k<adj_vertices.size(); ++k){
-          size_t adj_vid = adj_vertices[k];
-          if(!visited_flag[adj_vid] && fabs(sf[vid]-sf[adj_vid]) < LARGE_ZERO_EPSILON){
-            q.push(adj_vid);
-            visited_flag[adj_vid] = true;
-          } // end if
-        } // end for
-      }//end while      
-    } // end if
+    if(visited_flag[vid]) continue;
+    unsigned long long key = RadixKey(sf[vid]);
+    key_vec[tail++] = make_pair(key, (int)vid);
+    visited_flag[vid] = true;
+    while(head < tail){
+      int v = key_vec[head++].second;
+      VertHandleSpan adj_vertices = mesh.getAdjVertices(v);
+      for(size_t k=0; k<adj_vertices.size(); ++k){
+        size_t adj_vid = adj_vertices[k];
+        if(!visited_flag[adj_vid] && fabs(sf[vid]-sf[adj_vid]) < LARGE_ZERO_EPSILON){
+          key_vec[tail++] = make_pair(key, (int)adj_vid);
+          visited_flag[adj_vid] = true;
+        } // end if
+      } // end for
+    }//end while
   }
-  assert(msc.vert_priority_mp.size() == vert_num);
+  assert(tail == vert_num);
+
+  RadixSort(key_vec);
+  msc.vert_rank_vec.resize(vert_num);
+  for(size_t k=0; k<vert_num; ++k) msc.vert_rank_vec[key_vec[k].second] = k;
   return true;
 }
 
 
+void CPFinder::genUpperLink(){
+  int vert_num = mesh.getVertexNumber();
+  vector<int>& offset = msc.upper_link_offset;
+  offset.resize(vert_num+1);
+  offset[0] = 0;
+  for(int vid=0; vid<vert_num; ++vid)
+    offset[vid+1] = offset[vid] + linkWordNumber(mesh.getAdjVertices(vid).size());
+  msc.upper_link_vec.resize(offset[vert_num]);
+
+  const unsigned int* rank = &msc.vert_rank_vec[0];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid=0; vid<vert_num; ++vid){
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
+    if(adj_vertices.empty()) continue;
+    computeUpperLink(rank, rank[vid], adj_vertices.begin(), adj_vertices.size(),
+                     &msc.upper_link_vec[offset[vid]]);
+  }
+}
+
 bool CPFinder::findCriticalPoints(){
   if(!resolveFlatRegion()) return false;
+  genUpperLink();
+  int vert_num = mesh.getVertexNumber();
   CriticalPointArray& cp_vec = msc.cp_vec;
   cp_vec.clear(); msc.vert_cp_index_mp.clear();
-  msc.vert_cp_index_mp.resize(mesh.getVertexNumber(), -1);
-  for(size_t vid=0; vid<mesh.getVertexNumber(); ++vid){
-    CriticalPointType type = getPointType(vid);
-    if(type != REGULAR){
-      CriticalPoint cp;
-      cp.meshIndex = vid;
-      cp.type = type;
-      cp_vec.push_back(cp);
-      msc.vert_cp_index_mp[vid] = cp_vec.size()-1;
+  msc.vert_cp_index_mp.resize(vert_num, -1);
+
+  //! classify every vertex into a dense type array, counting the critical
+  //! points of each chunk, then place the chunks by a prefix sum so that
+  //! cp_vec is in vertex order whatever the number of threads
+  vector<unsigned char> type_vec(vert_num);
+  vector<unsigned char> multi_saddle_vec(vert_num, 0);
+  int chunk_num = 1;
+#ifdef _OPENMP
+  chunk_num = omp_get_max_threads();
+#endif
+  vector<int> chunk_offset(chunk_num+1, 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(chunk_num > 1)
+#endif
+  for(int c=0; c<chunk_num; ++c){
+    int first = (int)((long long)vert_num*c/chunk_num);
+    int last = (int)((long long)vert_num*(c+1)/chunk_num);
+    int cp_num = 0;
+    for(int vid=first; vid<last; ++vid){
+      bool multi_saddle = false;
+      CriticalPointType type = getPointType(vid, multi_saddle);
+      type_vec[vid] = type;
+      multi_saddle_vec[vid] = multi_saddle;
+      if(type != REGULAR) ++cp_num;
     }
+    chunk_offset[c+1] = cp_num;
   }
-  return true;
-}
-
-CriticalPointType CPFinder::getPointType(int vid) const{  
-  const VertHandleArray& adj_vertices = mesh.getAdjVertices(vid);
-  if(adj_vertices.size() == 0) return REGULAR;
-  vector<bool> adj_vflag;
-
-  for(size_t k=0; k<adj_vertices.size(); ++k){
-    int _vid = adj_vertices[k];
-    if(msc.cmpScalarValue(vid, _vid) == 1) adj_vflag.push_back(false);
-    else if(msc.cmpScalarValue(vid, _vid) == -1) adj_vflag.push_back(true);
+  for(int c=0; c<chunk_num; ++c) chunk_offset[c+1] += chunk_offset[c];
+
+  cp_vec.resize(chunk_offset[chunk_num]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(chunk_num > 1)
+#endif
+  for(int c=0; c<chunk_num; ++c){
+    int first = (int)((long long)vert_num*c/chunk_num);
+    int last = (int)((long long)vert_num*(c+1)/chunk_num);
+    int cp_index = chunk_offset[c];
+    for(int vid=first; vid<last; ++vid){
+      if(type_vec[vid] == REGULAR) continue;
+      cp_vec[cp_index].meshIndex = vid;
+      cp_vec[cp_index].type = (CriticalPointType)type_vec[vid];
+      msc.vert_cp_index_mp[vid] = cp_index++;
+    }
   }
 
-  if(mesh.isBoundaryVertex(vid)){
-    adj_vflag.insert(adj_vflag.end(), adj_vflag.rbegin()+1, adj_vflag.rend()-1);
+  for(size_t k=0; k<cp_vec.size(); ++k){
+    if(multi_saddle_vec[cp_vec[k].meshIndex])
+      cout << "This is a multi-saddle " << cp_vec[k].meshIndex << endl;
   }
+  return true;
+}
 
-  int alter_num(0);
-  for(size_t k=0; k<adj_vflag.size(); ++k){
-    if(adj_vflag[k] != adj_vflag[(k+1)%adj_vflag.size()]) ++alter_num;
-  }
+CriticalPointType CPFinder::getPointType(int vid, bool& multi_saddle) const{
+  multi_saddle = false;
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
+  size_t adj_num = adj_vertices.size();
+  if(adj_num == 0) return REGULAR;
+
+  //! the ring of a boundary vertex is open, it is closed by mirroring it
+  //! without its end vertices
+  bool is_boundary = mesh.isBoundaryVertex(vid);
+  const LinkWord* upper_link = msc.getUpperLink(vid);
+  int alter_num = countLinkAlternations(upper_link, adj_num, is_boundary);
 
   assert(alter_num %2 == 0);
   if(alter_num == 0){
-    return msc.cmpScalarValue(vid, adj_vertices[0]) == 1 ? MAXIMAL : MINIMAL;
+    return testLinkBit(upper_link, 0) ? MINIMAL : MAXIMAL;
   }else if(alter_num == 2) return REGULAR;
   else {
-    if(mesh.isBoundaryVertex(vid) && rm_boundary_saddle) return REGULAR;
-    if(alter_num != 4) cout << "This is a multi-saddle " << vid << endl;
+    if(is_boundary && rm_boundary_saddle) return REGULAR;
+    multi_saddle = (alter_num != 4);
     return SADDLE;
   }
 }
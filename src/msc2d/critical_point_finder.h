@@ -20,7 +20,12 @@ namespace msc2d{
 
  private:
     bool resolveFlatRegion();
-    CriticalPointType getPointType(int mesh_point_index) const;
+    void genUpperLink();
+    /*
+      classify one vertex from the upper/lower alternations of its one-ring
+      @param multi_saddle: set when the vertex is a saddle of more than 4 sectors
+    */
+    CriticalPointType getPointType(int mesh_point_index, bool& multi_saddle) const;
     
  private:
     const meshlib::Mesh& mesh;
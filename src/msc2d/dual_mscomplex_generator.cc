@@ -1,6 +1,10 @@
 #include "dual_mscomplex_generator.h"
 #include "../mesh/Mesh.h"
+#include "../mesh/MeshPathFinder.h"
 #include <set>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace meshlib;
@@ -25,7 +29,9 @@ void DualGenerator::generateDualCP(){
 }
 
 void DualGenerator::generateDualIL() {
+  //! first pass: place the dual lines and their end points in patch order
   qp_dual_il_map.resize(qp_vec.size(), -1);
+  vector<int> path_patch_vec;
   for(size_t i=0; i<qp_vec.size(); ++i){
     const QuadPatch& qp = qp_vec[i];
     IntegrationLine dual_il;
@@ -40,26 +46,40 @@ void DualGenerator::generateDualIL() {
       pair<int, int> mm_pair = getMaxMinPair(qp);
       dual_il.startIndex = cp_mapping[mm_pair.first];
       dual_il.endIndex = cp_mapping[mm_pair.second];
-      set<EdgeHandle> edge_set;
-      for(size_t j=0; j<qp.boundaryIntegrationLineIndex.size(); ++j){
-        const PATH& path = il_vec[qp.boundaryIntegrationLineIndex[j]].path;
-        for(size_t k=0; k<path.size()-1; ++k){
-          edge_set.insert(msc.mesh->getEdgeHandle(path[k], path[k+1]));
-        }
-      }
-      for(size_t j=0; j<qp.face.size(); ++j){
-        const VertHandleArray& eh_vec = msc.mesh->getFaceEdges(qp.face[j]);
-        for(size_t k=0; k<eh_vec.size(); ++k) edge_set.insert(eh_vec[k]);
-      }
-      int startVid = dual_cp_vec[dual_il.startIndex].meshIndex;
-      int endVid = dual_cp_vec[dual_il.endIndex].meshIndex;
-      if(!msc.mesh->getShortestPath(startVid, endVid, dual_il.path, edge_set))
-        cerr << "cannot form dual path for patch " << i << endl;
-
       dual_il_vec.push_back(dual_il);
+      path_patch_vec.push_back(i);
     }
     qp_dual_il_map[i] = dual_il_vec.size()-1;
   }
+
+  //! second pass: the paths across quad patches are independent queries,
+  //! searched inside the patch faces and boundary with one finder per thread
+  int path_num = path_patch_vec.size();
+  vector<char> path_ok(path_num, 1);
+#ifdef _OPENMP
+#pragma omp parallel if(path_num > 1)
+#endif
+  {
+    MeshPathFinder finder(*msc.mesh, msc.path_search_mode);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 4)
+#endif
+    for(int k=0; k<path_num; ++k){
+      int pid = path_patch_vec[k];
+      const QuadPatch& qp = qp_vec[pid];
+      IntegrationLine& dual_il = dual_il_vec[qp_dual_il_map[pid]];
+      finder.setAllowedFaces(qp.face);
+      for(size_t j=0; j<qp.boundaryIntegrationLineIndex.size(); ++j)
+        finder.addAllowedPath(il_vec[qp.boundaryIntegrationLineIndex[j]].path);
+      int startVid = dual_cp_vec[dual_il.startIndex].meshIndex;
+      int endVid = dual_cp_vec[dual_il.endIndex].meshIndex;
+      path_ok[k] = finder.getShortestPath(startVid, endVid, dual_il.path);
+    }
+  }
+  for(int k=0; k<path_num; ++k){
+    if(!path_ok[k])
+      cerr << "cannot form dual path for patch " << path_patch_vec[k] << endl;
+  }
 }
 
 void DualGenerator::generateDualPatch(){
@@ -3,6 +3,9 @@
 #include "../mesh/Mesh.h"
 #include "../util/utility.h"
 #include <stack>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace meshlib;
@@ -26,7 +29,10 @@ size_t ILTracer::prev(int vid, size_t curr_index) const{
 }
 
 bool ILTracer::traceIntegrationLine(){
+  error_rule_vec.clear();
+  msc.genSlotGradient();
   if(!createWEdge()) return false;
+  genSteepestNeighbor();
   if(!traceAscendingPath()) return false;
   setAscendingPathData();
   if(!traceDescendingPath()) return false;
@@ -36,12 +42,20 @@ bool ILTracer::traceIntegrationLine(){
 }
 
 bool ILTracer::createWEdge(){
-  wedge_vec.clear(); wedge_vec.resize(mesh.getVertexNumber());
-    
-  for(size_t vid = 0; vid<mesh.getVertexNumber(); ++vid){
+  //! clear the ranges in place so their storage is reused by the next field
+  int vert_num = mesh.getVertexNumber();
+  wedge_vec.resize(vert_num);
+
+  //! the ranges are the runs of set (max) and unset (min) bits of the
+  //! upper link, emitted from the first max range on
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid = 0; vid<vert_num; ++vid){
     WEdge& we = wedge_vec[vid];
-    const VertHandleArray& adj_vertices = mesh.getAdjVertices(vid);
-    size_t n = adj_vertices.size();
+    we.max_ranges.clear();
+    we.min_ranges.clear();
+    size_t n = mesh.getAdjVertices(vid).size();
     if(n==0) continue;
     if(msc.getVertexType(vid) == MAXIMAL){
       we.max_ranges.push_back(make_pair(0, n)); continue;
@@ -49,16 +63,16 @@ bool ILTracer::createWEdge(){
       we.min_ranges.push_back(make_pair(0, n)); continue;
     }
 
+    const LinkWord* upper = msc.getUpperLink(vid);
+    bool is_boundary = mesh.isBoundaryVertex(vid);
     size_t start_maxp = n;    
     //! get the first max-range's start position
     for(size_t i=0; i<n; ++i){
-      if(msc.cmpScalarValue(vid, adj_vertices[i]) == -1){
-        if( mesh.isBoundaryVertex(vid) && i==0){
+      if(testLinkBit(upper, i)){
+        if(is_boundary && i==0){
           start_maxp = 0; break;
-        }else{
-          if(msc.cmpScalarValue(vid, adj_vertices[prev(vid, i)]) == 1){
-            start_maxp = i; break;
-          }
+        }else if(!testLinkBit(upper, prev(vid, i))){
+          start_maxp = i; break;
         }
       }
     }    
@@ -66,105 +80,227 @@ bool ILTracer::createWEdge(){
 
     size_t start_idx(start_maxp);
     for(size_t i=next(vid, start_maxp), j=0; j<n; i=next(vid, i), ++j){
-      if(mesh.isBoundaryVertex(vid) && i==n){ //! handle boundary
-        if(msc.cmpScalarValue(vid, adj_vertices[i-1]) == -1){
+      if(is_boundary && i==n){ //! handle boundary
+        if(testLinkBit(upper, i-1)){
           we.max_ranges.push_back(make_pair(start_idx, n)); start_idx = 0;
-        }else if(msc.cmpScalarValue(vid, adj_vertices[i-1]) == 1){
+        }else{
           we.min_ranges.push_back(make_pair(start_idx, n)); start_idx = 0;
         }
       }else{ //! general case
-        if(msc.cmpScalarValue(vid, adj_vertices[i]) == -1 &&
-           msc.cmpScalarValue(vid, adj_vertices[prev(vid, i)]) ==1){
+        bool curr_upper = testLinkBit(upper, i);
+        if(curr_upper == testLinkBit(upper, prev(vid, i))) continue;
+        if(curr_upper){
           we.min_ranges.push_back(make_pair(start_idx, i)); start_idx = i;
-        }else if(msc.cmpScalarValue(vid, adj_vertices[i]) == 1 &&
-                 msc.cmpScalarValue(vid, adj_vertices[prev(vid,i)]) == -1){
+        }else{
           we.max_ranges.push_back(make_pair(start_idx, i)); start_idx = i;
         }
       }
     }    
-    if(!mesh.isBoundaryVertex(vid))
+    if(!is_boundary)
       assert(we.max_ranges.size() == we.min_ranges.size());
   }
 
   return true;
 }
 
-bool ILTracer::traceAscendingPath(){
-  cout << "Trace ascending path" << endl;
-  for(vector<CriticalPoint>::iterator it = msc.cp_vec.begin(); it != msc.cp_vec.end(); ++it){
-    if(it->type == SADDLE) {
-      CriticalPoint& sad = *it;
-      const vector<pair<size_t, size_t> >& max_ranges = wedge_vec[sad.meshIndex].max_ranges;
-      for(size_t k=0; k<max_ranges.size(); ++k){
-        int prev_vid = -1, curr_vid = sad.meshIndex;
-        msc.il_vec.push_back(IntegrationLine());        
-        IntegrationLine& il=msc.il_vec[msc.il_vec.size()-1];
-        PATH& mesh_path = il.path; mesh_path.push_back(curr_vid);
-        do{
-          pair<int, int> range;// get right range to trace gradient
-          if(mesh_path.size()==1) range = max_ranges[k];
-          else{
-            if(msc.getVertexType(curr_vid) == SADDLE){ // select the previous adjacent maxrange              
-              int range_idx = getRangeIndex(curr_vid, prev_vid);              
-              if(wedge_vec[curr_vid].max_ranges.size() <= range_idx){//at boundary 
-                --range_idx;
-                error_rule_vec.push_back(make_pair(curr_vid, range_idx+1));
-              }
-              range = wedge_vec[curr_vid].max_ranges[range_idx];
-            }else range = wedge_vec[curr_vid].max_ranges[0];
-          }
-          prev_vid = curr_vid;
-          curr_vid = getGradDirection(curr_vid, range);
-          assert(curr_vid != -1);
-          mesh_path.push_back(curr_vid);
-          assert(mesh_path.size() < mesh.getEdgeNumber());
-        }while(msc.getVertexType(curr_vid) != MAXIMAL);
-        il.startIndex = msc.vert_cp_index_mp[it->meshIndex];
-        il.endIndex = msc.vert_cp_index_mp[curr_vid];        
+void ILTracer::genSteepestNeighbor(){
+  //! a regular vertex has one max and one min range, so the gradient
+  //! direction out of it is fixed for the field
+  //! the two ranges split the ring, so every slot gradient is computed
+  //! once. ties go to the first slot from the range start, as in
+  //! getGradDirection
+  int vert_num = mesh.getVertexNumber();
+  steepest_up_vec.resize(vert_num);
+  steepest_down_vec.resize(vert_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid=0; vid<vert_num; ++vid){
+    steepest_up_vec[vid] = steepest_down_vec[vid] = -1;
+    const WEdge& we = wedge_vec[vid];
+    if(msc.getVertexType(vid) != REGULAR || we.max_ranges.empty() || we.min_ranges.empty())
+      continue;
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
+    DoubleSpan edge_len = mesh.getAdjEdgeLengths(vid);
+    const double* slot_grad = msc.slot_grad_vec.empty() ? NULL :
+        &msc.slot_grad_vec[mesh.getAdjSlotOffset(vid)];
+    size_t n = adj_vertices.size();
+    //! slot after n-1 is n for an open ring, 0 for a closed one
+    size_t wrap = mesh.isBoundaryVertex(vid) ? n : 0;
+    for(int dir=0; dir<2; ++dir){
+      const pair<size_t, size_t>& range = dir == 0 ? we.max_ranges[0] : we.min_ranges[0];
+      double grad = -1.0;
+      int grad_dir = -1;
+      for(size_t i=range.first; i!=range.second; i = (i+1 == n) ? wrap : i+1){
+        double cur_grad = fabs(slot_grad ? slot_grad[i] : msc.calGradient(vid, adj_vertices[i], edge_len[i]));
+        if(cur_grad > grad) { grad = cur_grad; grad_dir = adj_vertices[i];}
       }
+      (dir == 0 ? steepest_up_vec : steepest_down_vec)[vid] = grad_dir;
     }
   }
+}
+
+bool ILTracer::traceAscendingPath(){
+  cout << "Trace ascending path" << endl;
+  //! saddles are traced in one contiguous block per thread, each block
+  //! into its own buffers. the buffers are appended in block order, so
+  //! il_vec and error_rule_vec are laid out as in a serial run
+  vector<int> sad_vec;
+  int block_num = getSaddleBlocks(sad_vec);
+  vector<IntegrationLineArray> block_il_vec(block_num);
+  vector< vector< pair<int, int> > > block_err_vec(block_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(block_num > 1)
+#endif
+  for(int b=0; b<block_num; ++b){
+    size_t first = sad_vec.size()*b/block_num, last = sad_vec.size()*(b+1)/block_num;
+    for(size_t s=first; s<last; ++s)
+      traceAscendingPath(msc.cp_vec[sad_vec[s]], block_il_vec[b], block_err_vec[b]);
+  }
+  for(int b=0; b<block_num; ++b){
+    appendIntegrationLine(block_il_vec[b]);
+    error_rule_vec.insert(error_rule_vec.end(), block_err_vec[b].begin(), block_err_vec[b].end());
+  }
   return true;
 }
 
+void ILTracer::traceAscendingPath(const CriticalPoint& sad, IntegrationLineArray& il_buf,
+                                  vector< pair<int, int> >& err_buf) const{
+  const vector<pair<size_t, size_t> >& max_ranges = wedge_vec[sad.meshIndex].max_ranges;
+  for(size_t k=0; k<max_ranges.size(); ++k){
+    int prev_vid = -1, curr_vid = sad.meshIndex;
+    il_buf.push_back(IntegrationLine());
+    IntegrationLine& il = il_buf.back();
+    PATH& mesh_path = il.path; mesh_path.push_back(curr_vid);
+    do{
+      int next_vid;
+      if(mesh_path.size()==1) next_vid = getGradDirection(curr_vid, max_ranges[k]);
+      else if(msc.getVertexType(curr_vid) == SADDLE){ // select the previous adjacent maxrange
+        int range_idx = getRangeIndex(curr_vid, prev_vid);
+        if(wedge_vec[curr_vid].max_ranges.size() <= range_idx){//at boundary 
+          --range_idx;
+          err_buf.push_back(make_pair(curr_vid, range_idx+1));
+        }
+        next_vid = getGradDirection(curr_vid, wedge_vec[curr_vid].max_ranges[range_idx]);
+      }else next_vid = steepest_up_vec[curr_vid];
+      prev_vid = curr_vid;
+      curr_vid = next_vid;
+      assert(curr_vid != -1);
+      mesh_path.push_back(curr_vid);
+      assert(mesh_path.size() < mesh.getEdgeNumber());
+    }while(msc.getVertexType(curr_vid) != MAXIMAL);
+    il.startIndex = msc.vert_cp_index_mp[sad.meshIndex];
+    il.endIndex = msc.vert_cp_index_mp[curr_vid];
+  }
+}
+
+int ILTracer::getSaddleBlocks(vector<int>& sad_vec) const{
+  sad_vec.clear();
+  for(size_t k=0; k<msc.cp_vec.size(); ++k)
+    if(msc.cp_vec[k].type == SADDLE) sad_vec.push_back(k);
+  int block_num = 1;
+#ifdef _OPENMP
+  block_num = omp_get_max_threads();
+#endif
+  if(block_num > (int)sad_vec.size()) block_num = max((int)sad_vec.size(), 1);
+  return block_num;
+}
+
+void ILTracer::appendIntegrationLine(IntegrationLineArray& il_buf){
+  //! move the paths instead of copying them
+  size_t il_num = msc.il_vec.size();
+  msc.il_vec.resize(il_num + il_buf.size());
+  for(size_t k=0; k<il_buf.size(); ++k){
+    IntegrationLine& il = msc.il_vec[il_num+k];
+    il.startIndex = il_buf[k].startIndex;
+    il.endIndex = il_buf[k].endIndex;
+    il.path.swap(il_buf[k].path);
+  }
+  il_buf.clear();
+}
+
+int ILTracer::getSlotIndex(int vid, int adj_vid) const{
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
+  for(size_t k=0; k<adj_vertices.size(); ++k)
+    if(adj_vertices[k] == adj_vid) return mesh.getAdjSlotOffset(vid) + k;
+  return -1;
+}
+
 void ILTracer::setAscendingPathData(){
-  //! set junction flag , in/out vertices info and vert-path mapping
+  //! set junction flag, in/out slot flags and the slot-path mapping.
+  //! slot s = getAdjSlotOffset(v)+k stands for the k-th neighbor of v:
+  //! in_path_csr[s] lists the paths through edge (neighbor, v) and
+  //! out_path_csr[s] the paths through edge (v, neighbor), in path order
   size_t vert_num = mesh.getVertexNumber();
-  junction_flag.clear(); junction_flag.resize(vert_num);
-  in_vertices.clear(); in_vertices.resize(vert_num);
-  out_vertices.clear(); out_vertices.resize(vert_num);
-  edge_path_mp.clear();
+  size_t slot_num = mesh.getAdjSlotOffset(vert_num);
+  junction_flag.assign(vert_num, false);
+  slot_flag_vec.assign(slot_num, 0);
+  in_path_csr.offset.assign(slot_num+1, 0);
+  out_path_csr.offset.assign(slot_num+1, 0);
+  //! out and in slot of every path edge, kept for the fill pass
+  vector<int> edge_slot_vec;
   for(size_t k=0; k<msc.il_vec.size(); ++k){
     const PATH& path = msc.il_vec[k].path;
     for(size_t i=0; i<path.size(); ++i){
       int vid = path[i];
       if(msc.getVertexType(vid) == REGULAR) junction_flag[vid] = true;
-      if(i!=0) in_vertices[vid].push_back(path[i-1]);
-      if(i!=path.size()-1) out_vertices[vid].push_back(path[i+1]);
-      if(i>0) edge_path_mp[make_pair(path[i-1], vid)].push_back(k);
-    }    
+      if(i == 0) continue;
+      int out_slot = getSlotIndex(path[i-1], vid);
+      int in_slot = getSlotIndex(vid, path[i-1]);
+      assert(out_slot != -1 && in_slot != -1);
+      slot_flag_vec[out_slot] |= SLOT_OUT;
+      slot_flag_vec[in_slot] |= SLOT_IN;
+      ++out_path_csr.offset[out_slot+1];
+      ++in_path_csr.offset[in_slot+1];
+      edge_slot_vec.push_back(out_slot);
+      edge_slot_vec.push_back(in_slot);
+    }
+  }
+  for(size_t s=0; s<slot_num; ++s){
+    out_path_csr.offset[s+1] += out_path_csr.offset[s];
+    in_path_csr.offset[s+1] += in_path_csr.offset[s];
+  }
+  out_path_csr.index.resize(out_path_csr.offset[slot_num]);
+  in_path_csr.index.resize(in_path_csr.offset[slot_num]);
+  vector<int> out_pos(out_path_csr.offset.begin(), out_path_csr.offset.end()-1);
+  vector<int> in_pos(in_path_csr.offset.begin(), in_path_csr.offset.end()-1);
+  size_t e = 0;
+  for(size_t k=0; k<msc.il_vec.size(); ++k){
+    for(size_t i=1; i<msc.il_vec[k].path.size(); ++i, e+=2){
+      out_path_csr.index[out_pos[edge_slot_vec[e]]++] = k;
+      in_path_csr.index[in_pos[edge_slot_vec[e+1]]++] = k;
+    }
+  }
+  //! an error rule (vid, r) is flagged on the first slot of min range r
+  for(size_t k=0; k<error_rule_vec.size(); ++k){
+    int vid = error_rule_vec[k].first, range_idx = error_rule_vec[k].second;
+    const vector<pair<size_t, size_t> >& min_ranges = wedge_vec[vid].min_ranges;
+    if(range_idx < (int)min_ranges.size())
+      slot_flag_vec[mesh.getAdjSlotOffset(vid) + min_ranges[range_idx].first] |= SLOT_ERROR_RULE;
   }
 }
 
 
 int ILTracer::getGradDirection(int vid, const pair<size_t, size_t>& range) const{
-  const VertHandleArray& adj_vertices = mesh.getAdjVertices(vid);
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
+  DoubleSpan edge_len = mesh.getAdjEdgeLengths(vid);
+  const double* slot_grad = msc.slot_grad_vec.empty() ? NULL :
+      &msc.slot_grad_vec[mesh.getAdjSlotOffset(vid)];
   double grad = -1.0;
   int grad_dir = -1;
   for(size_t i=range.first; i!=range.second; i=next(vid, i)){
-    double cur_grad = fabs(msc.calGradient(vid, adj_vertices[i]));
+    double cur_grad = fabs(slot_grad ? slot_grad[i] : msc.calGradient(vid, adj_vertices[i], edge_len[i]));
     if(cur_grad > grad) { grad = cur_grad; grad_dir = adj_vertices[i];}
   }
   return grad_dir; 
 }
 
 int ILTracer::getRangeIndex(int vid, int adj_vid) const{
-  const vector<int>& adj_vertices = mesh.getAdjVertices(vid);
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
   if(!Util::isIn(adj_vertices, adj_vid)) return -1;
   const WEdge& we = wedge_vec[vid];
-  vector<pair<size_t, size_t> >  ranges;
-  if(msc.cmpScalarValue(vid, adj_vid) == 1) ranges = we.min_ranges;
-  else ranges = we.max_ranges;
+  const vector<pair<size_t, size_t> >& ranges =
+      msc.cmpScalarValue(vid, adj_vid) == 1 ? we.min_ranges : we.max_ranges;
   for(size_t k=0; k<ranges.size(); ++k){
     for(size_t j=ranges[k].first; j!=ranges[k].second; j=next(vid, j)){
       if(adj_vertices[j] == adj_vid) return k;
@@ -176,61 +312,85 @@ int ILTracer::getRangeIndex(int vid, int adj_vid) const{
 
 bool ILTracer::traceDescendingPath(){
   cout << "Trace descending path" << endl;
-  for(vector<CriticalPoint>::iterator it=msc.cp_vec.begin(); it!=msc.cp_vec.end(); ++it){
-    if(it->type == SADDLE){
-      if(it->meshIndex == 192)
-      const vector<pair<size_t, size_t> >& min_ranges = wedge_vec[it->meshIndex].min_ranges;
-      for(size_t k=0; k<min_ranges.size(); ++k){
-       // cout << it->meshIndex << " " << k << endl;
-        path_side_record.clear();
-        int prev_vid = it->meshIndex;
-        int curr_vid = getDescendingPathSecondVert(*it, k);
-
-        IntegrationLine il;
-        PATH& path = il.path;
-        path.push_back(prev_vid); path.push_back(curr_vid);
-        while(msc.getVertexType(curr_vid) != MINIMAL){
-          pair<int, int> range;
-          if(msc.getVertexType(curr_vid) == SADDLE){
-            range = getMinRangeAtSaddle(curr_vid, prev_vid);
-          }else if(msc.getVertexType(curr_vid) == REGULAR){
-            if(junction_flag[curr_vid] == true){
-              range = getMinRangeAtJunction(curr_vid, prev_vid);
-            }else range = wedge_vec[curr_vid].min_ranges[0];
-          }
-          if(range.first == -1 && range.second == -1) break;
-          prev_vid = curr_vid;
-          curr_vid = getGradDirection(curr_vid, range);
-          assert(curr_vid != -1);
-          path.push_back(curr_vid);
-          assert(path.size() < mesh.getEdgeNumber());
-        }
-        if(msc.getVertexType(curr_vid) != MINIMAL) continue;
-        il.startIndex = msc.vert_cp_index_mp[it->meshIndex];
-        il.endIndex = msc.vert_cp_index_mp[curr_vid];
-        msc.il_vec.push_back(il);
+  //! the descending traces only read the ascending path data, and the
+  //! side record is reset per trace, so they are blocked as the ascending
+  //! ones, with one side record per block
+  vector<int> sad_vec;
+  int block_num = getSaddleBlocks(sad_vec);
+  vector<IntegrationLineArray> block_il_vec(block_num);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(block_num > 1)
+#endif
+  for(int b=0; b<block_num; ++b){
+    size_t first = sad_vec.size()*b/block_num, last = sad_vec.size()*(b+1)/block_num;
+    SideRecord path_side_record(msc.il_vec.size());
+    for(size_t s=first; s<last; ++s)
+      traceDescendingPath(msc.cp_vec[sad_vec[s]], block_il_vec[b], path_side_record);
+  }
+  for(int b=0; b<block_num; ++b) appendIntegrationLine(block_il_vec[b]);
+  return true;
+}
+
+void ILTracer::traceDescendingPath(const CriticalPoint& sad, IntegrationLineArray& il_buf,
+                                   SideRecord& path_side_record) const{
+  const vector<pair<size_t, size_t> >& min_ranges = wedge_vec[sad.meshIndex].min_ranges;
+  for(size_t k=0; k<min_ranges.size(); ++k){
+    path_side_record.reset();
+    int prev_vid = sad.meshIndex;
+    int curr_vid = getDescendingPathSecondVert(sad, k, path_side_record);
+
+    IntegrationLine il;
+    PATH& path = il.path;
+    path.push_back(prev_vid); path.push_back(curr_vid);
+    while(msc.getVertexType(curr_vid) != MINIMAL){
+      pair<int, int> range;
+      if(msc.getVertexType(curr_vid) == REGULAR && !junction_flag[curr_vid]){
+        //! plain regular vertex, follow the precomputed direction
+        prev_vid = curr_vid;
+        curr_vid = steepest_down_vec[prev_vid];
+        assert(curr_vid != -1);
+        path.push_back(curr_vid);
+        assert(path.size() < mesh.getEdgeNumber());
+        continue;
       }
+      if(msc.getVertexType(curr_vid) == SADDLE){
+        range = getMinRangeAtSaddle(curr_vid, prev_vid, path_side_record);
+      }else if(msc.getVertexType(curr_vid) == REGULAR){
+        range = getMinRangeAtJunction(curr_vid, prev_vid, path_side_record);
+      }
+      if(range.first == -1 && range.second == -1) break;
+      prev_vid = curr_vid;
+      curr_vid = getGradDirection(curr_vid, range);
+      assert(curr_vid != -1);
+      path.push_back(curr_vid);
+      assert(path.size() < mesh.getEdgeNumber());
     }
+    if(msc.getVertexType(curr_vid) != MINIMAL) continue;
+    il.startIndex = msc.vert_cp_index_mp[sad.meshIndex];
+    il.endIndex = msc.vert_cp_index_mp[curr_vid];
+    il_buf.push_back(IntegrationLine());
+    il_buf.back().startIndex = il.startIndex;
+    il_buf.back().endIndex = il.endIndex;
+    il_buf.back().path.swap(path);
   }
-  return true;
 }
 
-int ILTracer::getDescendingPathSecondVert(const CriticalPoint& cp, int range_index){
-  const VertHandleArray& adj_vertices = mesh.getAdjVertices(cp.meshIndex);
+int ILTracer::getDescendingPathSecondVert(const CriticalPoint& cp, int range_index,
+                                         SideRecord& path_side_record) const{
+  const unsigned char* slot_flag = &slot_flag_vec[mesh.getAdjSlotOffset(cp.meshIndex)];
   const pair<size_t, size_t>& min_r = wedge_vec[cp.meshIndex].min_ranges[range_index];
   pair<size_t, size_t> range= min_r;
-  int last_adj_vid(-1);
-  bool err_rule = Util::isIn(error_rule_vec, make_pair(cp.meshIndex, range_index));
+  int last_slot(-1);
+  bool err_rule = (slot_flag[min_r.first] & SLOT_ERROR_RULE) != 0;
   for(size_t k=min_r.first; k!=min_r.second; k=next(cp.meshIndex, k)){
-    int adj_vid = adj_vertices[k];
-    if(Util::isIn(in_vertices[cp.meshIndex], adj_vid)){
-      last_adj_vid = adj_vid;
+    if(slot_flag[k] & SLOT_IN){
+      last_slot = k;
       if(!err_rule) {range.first = k; }
       else { range.second = next(cp.meshIndex,k); break;}
     }
   }
-  if(last_adj_vid !=-1){
-    const vector<size_t>& paths = edge_path_mp[make_pair(last_adj_vid, cp.meshIndex)];
+  if(last_slot !=-1){
+    ArraySpan<int> paths = in_path_csr[mesh.getAdjSlotOffset(cp.meshIndex) + last_slot];
     for(size_t k=0; k<paths.size(); ++k){
       if(!err_rule) path_side_record[paths[k]] = 1; // back direction
       else path_side_record[paths[k]] = -1;
@@ -239,23 +399,24 @@ int ILTracer::getDescendingPathSecondVert(const CriticalPoint& cp, int range_ind
   return getGradDirection(cp.meshIndex, range);
 }
 
-pair<size_t, size_t> ILTracer::getMinRangeAtJunction(int curr_vid, int prev_vid){
-  const VertHandleArray& adj_vertices = mesh.getAdjVertices(curr_vid);
-  const vector<int>& in_verts = in_vertices[curr_vid];
-  const vector<int>& out_verts = out_vertices[curr_vid];
+pair<size_t, size_t> ILTracer::getMinRangeAtJunction(int curr_vid, int prev_vid,
+                                                     SideRecord& path_side_record) const{
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(curr_vid);
+  int slot_offset = mesh.getAdjSlotOffset(curr_vid);
+  const unsigned char* slot_flag = &slot_flag_vec[slot_offset];
   const pair<size_t, size_t>& max_r = wedge_vec[curr_vid].max_ranges[0];
   const pair<size_t, size_t>& min_r = wedge_vec[curr_vid].min_ranges[0];
   bool visited_flag = false;
   for(size_t k=max_r.first; k!=max_r.second; k=next(curr_vid, k)){
     int adj_vid = adj_vertices[k];
     if(adj_vid == prev_vid) visited_flag = true;
-    if(Util::isIn(out_verts, adj_vid)){
+    if(slot_flag[k] & SLOT_OUT){
       if(adj_vid == prev_vid) continue; //! side have set before
       int side = 0;
       if(visited_flag == true) side = 1;
       else side = -1;
       //! set path side flag
-      const vector<size_t>& path_ids = edge_path_mp[make_pair(curr_vid, adj_vid)];
+      ArraySpan<int> path_ids = out_path_csr[slot_offset + k];
       for(size_t i=0; i<path_ids.size(); ++i){
         path_side_record[path_ids[i]] = side;
       }
@@ -263,37 +424,36 @@ pair<size_t, size_t> ILTracer::getMinRangeAtJunction(int curr_vid, int prev_vid)
   }
   size_t first = min_r.first, second = min_r.second;
   for(size_t k=min_r.first; k!=min_r.second; k=next(curr_vid, k)){
-    int adj_vid = adj_vertices[k];
-    if(Util::isIn(in_verts, adj_vid)){
-      const vector<size_t>& path_ids = edge_path_mp[make_pair(adj_vid, curr_vid)];
+    if(slot_flag[k] & SLOT_IN){
+      ArraySpan<int> path_ids = in_path_csr[slot_offset + k];
       assert(path_ids.size() !=0);
-      map<size_t, int>::const_iterator im = path_side_record.find(path_ids[0]);
-      if(im == path_side_record.end()) {
+      if(!path_side_record.isSet(path_ids[0])) {
         cout << curr_vid <<" " << prev_vid << endl;
         //        return make_pair(-1, -1);
       }
-      assert(im != path_side_record.end());
-      if(im->second == -1) { second = next(curr_vid, k); break;}
+      assert(path_side_record.isSet(path_ids[0]));
+      if(path_side_record.get(path_ids[0]) == -1) { second = next(curr_vid, k); break;}
       else first = k;
     }
   }
   return make_pair(first, second);
 }
 
-pair<size_t, size_t> ILTracer::getMinRangeAtSaddle(int sadd_vid, int prev_vid) {
-  const VertHandleArray& adj_vertices = mesh.getAdjVertices(sadd_vid);
-  const vector<int>& in_verts = in_vertices[sadd_vid];
-  const vector<int>& out_verts = out_vertices[sadd_vid];
+pair<size_t, size_t> ILTracer::getMinRangeAtSaddle(int sadd_vid, int prev_vid,
+                                                   SideRecord& path_side_record) const{
+  VertHandleSpan adj_vertices = mesh.getAdjVertices(sadd_vid);
+  int slot_offset = mesh.getAdjSlotOffset(sadd_vid);
+  const unsigned char* slot_flag = &slot_flag_vec[slot_offset];
   int side = 0;
   int max_range_idx = getRangeIndex(sadd_vid, prev_vid);
   assert(max_range_idx != -1);
   const pair<size_t, size_t>& max_range = wedge_vec[sadd_vid].max_ranges[max_range_idx];
   for(size_t k=max_range.first; k!=max_range.second; k=next(sadd_vid, k)){
     int adj_vid = adj_vertices[k];
-    if(Util::isIn(out_verts, adj_vid)){
+    if(slot_flag[k] & SLOT_OUT){
       if(adj_vid != prev_vid) side = -1;
       else{
-        const vector<size_t>& path_ids = edge_path_mp[make_pair(sadd_vid, adj_vid)];
+        ArraySpan<int> path_ids = out_path_csr[slot_offset + k];
         assert(path_ids.size() > 0);
         side = path_side_record[path_ids[0]];
       }
@@ -302,9 +462,8 @@ pair<size_t, size_t> ILTracer::getMinRangeAtSaddle(int sadd_vid, int prev_vid) {
   }
   assert(side != 0);
   for(size_t k=max_range.first; k!=max_range.second; k=next(sadd_vid, k)){
-    int adj_vid = adj_vertices[k];
-    if(Util::isIn(in_verts, adj_vid)){
-      const vector<size_t>& path_ids = edge_path_mp[make_pair(adj_vid, sadd_vid)];
+    if(slot_flag[k] & SLOT_IN){
+      ArraySpan<int> path_ids = in_path_csr[slot_offset + k];
       assert(path_ids.size() > 0);
       for(size_t i=0; i<path_ids.size(); ++i)
         path_side_record[path_ids[i]] = side;
@@ -326,8 +485,7 @@ pair<size_t, size_t> ILTracer::getMinRangeAtSaddle(int sadd_vid, int prev_vid) {
   const pair<size_t, size_t>& min_range = wedge_vec[sadd_vid].min_ranges[min_range_idx];
   size_t first = min_range.first, second = min_range.second;
   for(size_t k=min_range.first; k!=min_range.second; k=next(sadd_vid, k)){
-    int adj_vid = adj_vertices[k];
-    if(Util::isIn(in_verts, adj_vid)){
+    if(slot_flag[k] & SLOT_IN){
       if(side == -1){ second = next(sadd_vid, k); break;}
       else if(side == 1) { first = k; }
     }
@@ -355,7 +513,7 @@ void ILTracer::sortCPNeighbor(CriticalPoint& cp) const{
     cp.neighbor.clear();
 
     const WEdge& we = wedge_vec[cp.meshIndex];
-    const VertHandleArray& adj_vertices = mesh.getAdjVertices(cp.meshIndex);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(cp.meshIndex);
     if(msc.mesh->isBoundaryVertex(cp.meshIndex)){
       for(size_t k=0; k<adj_vertices.size(); ++k){
         for(size_t i=0; i<nb_bak.size(); ++i){
@@ -389,7 +547,7 @@ void ILTracer::sortCPNeighbor(CriticalPoint& cp) const{
 
   if(mesh.isBoundaryVertex(cp.meshIndex)){
     // boundary cp's frist neighbor should also be a boundary
-    const VertHandleArray& adj_vertices = mesh.getAdjVertices(cp.meshIndex);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(cp.meshIndex);
     CriticalPointNeighborArray _nb = cp.neighbor;
     int first_index = -1;
     for(size_t i=0; i<adj_vertices.size(); ++i){
@@ -478,7 +636,7 @@ void ILTracer::replaceSaddle(vector<PATH>& path_vec, Tree& t) const{
         //! get the mapping vertex index
         bool ascending = (msc.cmpScalarValue(curr_vid, next_vid) == 1) ? false : true;
         const WEdge& we = wedge_vec[curr_vid];
-        const VertHandleArray& adj_vertices = mesh.getAdjVertices(curr_vid);
+        VertHandleSpan adj_vertices = mesh.getAdjVertices(curr_vid);
         int r_index = getRangeIndex(curr_vid, next_vid);
         if(ascending){
           int next_r_index = (r_index+1)%we.max_ranges.size();
@@ -564,7 +722,7 @@ void ILTracer::traverseTree(Tree& tree, vector<int>& il_index_vec) const{
     int vid = node;
     im = tree.node_vert_mp.find(node);
     if(im != tree.node_vert_mp.end())  vid = im->second;
-    const VertHandleArray& adj_vertices = mesh.getAdjVertices(vid);
+    VertHandleSpan adj_vertices = mesh.getAdjVertices(vid);
     size_t out_index;
     if(parent == -1) out_index = 0;
     else out_index = distance(adj_vertices.begin(),
@@ -663,7 +821,7 @@ void ILTracer::unfoldMultiSaddle(CriticalPoint& cp){
 
 void ILTracer::unfoldBoundaryMultiSaddle(CriticalPoint& cp){
   CriticalPointNeighborArray nb_vec = cp.neighbor;
-  const VertHandleArray& adj_vertices = msc.mesh->getAdjVertices(cp.meshIndex);
+  VertHandleSpan adj_vertices = msc.mesh->getAdjVertices(cp.meshIndex);
   for(size_t k=1; k<adj_vertices.size()-1; ++k){
     int adj_vid = adj_vertices[k];
     for(size_t i=0; i<cp.neighbor.size(); ++i){
@@ -685,7 +843,7 @@ bool ILTracer::isNormalSaddle(const CriticalPoint& cp) const{
   if(cp.type != SADDLE) return false;
 //  CriticalPointNeighborArray nb_vec = cp.neighbor;
 //  if(mesh.isBoundaryVertex(cp.meshIndex)){
-//    const VertHandleArray& adj_vertices = msc.mesh->getAdjVertices(cp.meshIndex);
+//    VertHandleSpan adj_vertices = msc.mesh->getAdjVertices(cp.meshIndex);
 //    for(size_t k=1; k<adj_vertices.size()-1; ++k){
 //      int adj_vid = adj_vertices[k];
 //      for(size_t i=0; i<cp.neighbor.size(); ++i){
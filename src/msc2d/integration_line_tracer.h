@@ -3,8 +3,10 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include "mscomplex.h"
+#include "../mesh/MeshElement.h"
 
 namespace meshlib{ class Mesh; }
 
@@ -30,6 +32,35 @@ namespace msc2d{
       std::map<int, int> node_path_mp;
     };
 
+    //! side of the ascending paths met by one descending trace, dense over
+    //! the path indices. reset() starts a new trace in O(1) by moving the
+    //! stamp, an entry is set only if it carries the current stamp
+    class SideRecord{
+   public:
+      SideRecord(size_t path_num): side(path_num, 0), stamp(path_num, 0), curr_stamp(0) {}
+      void reset() {
+        if(++curr_stamp == 0){ std::fill(stamp.begin(), stamp.end(), 0); curr_stamp = 1; }
+      }
+      bool isSet(size_t k) const { return stamp[k] == curr_stamp; }
+      int get(size_t k) const { return isSet(k) ? side[k] : 0; }
+      //! unset entries read as 0 and become set, as std::map::operator[]
+      int& operator[](size_t k) {
+        if(!isSet(k)) { stamp[k] = curr_stamp; side[k] = 0; }
+        return side[k];
+      }
+   private:
+      std::vector<int> side;
+      std::vector<unsigned int> stamp;
+      unsigned int curr_stamp;
+    };
+
+    //! flags of a one-ring slot (vid, k), k-th neighbor adj of vid
+    enum SLOTFLAG{
+      SLOT_IN = 0x01,        // edge (adj, vid) is on an ascending path
+      SLOT_OUT = 0x02,       // edge (vid, adj) is on an ascending path
+      SLOT_ERROR_RULE = 0x04 // first slot of a min range with a boundary error rule
+    };
+
     
  public:
     ILTracer(MSComplex2D&);
@@ -38,8 +69,16 @@ namespace msc2d{
     bool traceIntegrationLine();
  private:
     bool createWEdge();    
+    void genSteepestNeighbor();
     bool traceAscendingPath();    
     bool traceDescendingPath();
+    void traceAscendingPath(const CriticalPoint& sad, IntegrationLineArray& il_buf,
+                            std::vector< std::pair<int, int> >& err_buf) const;
+    void traceDescendingPath(const CriticalPoint& sad, IntegrationLineArray& il_buf,
+                             SideRecord& path_side_record) const;
+    //! saddle indices in cp_vec order, returns the number of trace blocks
+    int getSaddleBlocks(std::vector<int>& sad_vec) const;
+    void appendIntegrationLine(IntegrationLineArray& il_buf);
     void setAscendingPathData();
     void unfoldMultiSaddle();
     void unfoldMultiSaddle(CriticalPoint& cp);
@@ -57,22 +96,32 @@ namespace msc2d{
     size_t prev(int vid, size_t curr_index) const;
     int getRangeIndex(int vid, int adj_vid) const;
     int getGradDirection(int vid, const std::pair<size_t, size_t>& range) const;
-    int getDescendingPathSecondVert(const CriticalPoint& cp, int range_idx);
-    std::pair<size_t, size_t> getMinRangeAtSaddle(int curr_vid, int prev_vid);
-    std::pair<size_t, size_t> getMinRangeAtJunction(int curr_vid, int prev_vid);
+    //! Mesh::getAdjSlotOffset(vid) + position of adj_vid in the one-ring, -1 if not adjacent
+    int getSlotIndex(int vid, int adj_vid) const;
+    //! path_side_record: side of the ascending paths met by the current trace
+    int getDescendingPathSecondVert(const CriticalPoint& cp, int range_idx,
+                                    SideRecord& path_side_record) const;
+    std::pair<size_t, size_t> getMinRangeAtSaddle(int curr_vid, int prev_vid,
+                                                  SideRecord& path_side_record) const;
+    std::pair<size_t, size_t> getMinRangeAtJunction(int curr_vid, int prev_vid,
+                                                    SideRecord& path_side_record) const;
     bool isNormalSaddle(const CriticalPoint& cp) const;
     int getNeighborIndex(const CriticalPoint& cp, int il_index) const;
  private:
     std::vector<WEdge> wedge_vec;
+    //! steepest upper/lower neighbor of every regular vertex, -1 otherwise
+    std::vector<int> steepest_up_vec;
+    std::vector<int> steepest_down_vec;
     std::vector<bool> junction_flag;
-    std::vector< std::vector<int> > in_vertices; 
-    std::vector< std::vector<int> > out_vertices;
-    std::map< std::pair<int, int>, std::vector<size_t> > edge_path_mp;
-    std::map<size_t, int> path_side_record; //
+    //! SLOTFLAG bits and ascending paths of every one-ring slot,
+    //! see setAscendingPathData
+    std::vector<unsigned char> slot_flag_vec;
+    meshlib::HandleCSR in_path_csr;
+    meshlib::HandleCSR out_path_csr;
     std::vector< std::pair<int, int> > error_rule_vec;
 
     MSComplex2D& msc;
-    meshlib::Mesh& mesh;
+    const meshlib::Mesh& mesh;
   }; 
 } // end namespace
 
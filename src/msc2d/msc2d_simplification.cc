@@ -1,53 +1,104 @@
 #include "msc2d_simplification.h"
 #include "mscomplex.h"
+#include "../mesh/Mesh.h"
 #include "../common/macro.h"
 #include <limits>
 
 using namespace std;
 namespace msc2d{
 Simplifor::Simplifor(MSComplex2D& _msc, bool _rm_deg_sad):
-    msc(_msc), cp_vec(_msc.cp_vec), il_vec(_msc.il_vec), remove_deg_sad(_rm_deg_sad){}
+    msc(_msc), cp_vec(_msc.cp_vec), il_vec(_msc.il_vec), remove_deg_sad(_rm_deg_sad),
+    recorder(NULL), queue_flag(true){}
 Simplifor::~Simplifor(){}
 
-void Simplifor::calPersistence(){
-  vector<PersPair> pers_vec;
-  sum_persistence=0.0;
+double Simplifor::calSumPersistence() const{
+  double sum = 0.0;
   for(size_t k=0; k<il_vec.size(); ++k){
-    const IntegrationLine& il = il_vec[k];
-    double value = msc.calPersistence(il.startIndex, il.endIndex);
-    sum_persistence += value*value;
-    pers_vec.push_back(PersPair(k, value));
+    double value = msc.calPersistence(il_vec[k].startIndex, il_vec[k].endIndex);
+    sum += value*value;
   }
+  sum = sqrt(sum);
+  if(fabs(sum) < meshlib::LARGE_ZERO_EPSILON ) sum = 1.0;
+  return sum;
+}
+
+void Simplifor::calPersistence(){
   // normalize
-  sum_persistence = sqrt(sum_persistence);
-  if(fabs(sum_persistence) < meshlib::LARGE_ZERO_EPSILON ) sum_persistence = 1.0;
-  persistence_map.clear();
-  for(size_t i=0; i<pers_vec.size(); ++i){
-    double value = pers_vec[i].second/sum_persistence;
-    if(value <= cancel_threshold) persistence_map[pers_vec[i].first] = value;
+  sum_persistence = calSumPersistence();
+  persistence_heap.reserve(il_vec.size());
+  for(size_t k=0; k<il_vec.size(); ++k){
+    const IntegrationLine& il = il_vec[k];
+    double value = msc.calPersistence(il.startIndex, il.endIndex)/sum_persistence;
+    if(value <= cancel_threshold) persistence_heap.push(k, make_pair(value, (int)k));
   }
 }
 
 void Simplifor::simplify(double threshold){
-  cancel_threshold = threshold;
   cout << "Simplication, threshold = " << threshold << endl;
-  removed_il_flag.clear(); removed_il_flag.resize(il_vec.size(), false);
-  removed_cp_flag.clear(); removed_cp_flag.resize(cp_vec.size(), false);
+  beginSimplify(threshold);
   calPersistence();
-  while(persistence_map.size()){
-    double min_pers = numeric_limits<double>::infinity();
-    map<size_t, double>::iterator im, min_im;
-    for(im=persistence_map.begin(); im!=persistence_map.end(); ++im){
-      if(im->second < min_pers){
-        min_pers = im->second;
-        min_im = im;
-      }
-    }
-    size_t il_index = min_im->first;
-    persistence_map.erase(il_index);
+  while(!persistence_heap.empty()){
+    int il_index = persistence_heap.pop();
     cancel(il_index);
   }
+  endSimplify();
+}
+
+void Simplifor::recordHierarchy(double max_threshold, PersistenceHierarchy& h){
+  cout << "Record persistence hierarchy, threshold = " << max_threshold << endl;
+  beginSimplify(max_threshold);
+  calPersistence();
+  h.clear();
+  h.max_threshold = max_threshold;
+  h.sum_persistence = sum_persistence;
+  recorder = &h;
+  while(!persistence_heap.empty()){
+    PersistenceHierarchy::Cancellation c;
+    c.persistence = persistence_heap.topKey().first;
+    c.il_index = persistence_heap.pop();
+    c.saddle = il_vec[c.il_index].startIndex;
+    c.extremum = il_vec[c.il_index].endIndex;
+    c.target = -1;
+    c.rerouted_first = h.rerouted_vec.size();
+    c.rerouted_num = 0;
+    h.cancel_vec.push_back(c);
+    h.cancel_vec.back().cancelled = cancel(c.il_index);
+  }
+  recorder = NULL;
+  cout << h.cancel_vec.size() << " cancellations recorded" << endl;
+}
 
+bool Simplifor::replayHierarchy(const PersistenceHierarchy& h, double threshold){
+  cout << "Simplication, threshold = " << threshold << " (replay)" << endl;
+  beginSimplify(threshold);
+  //! the recorded order replaces the queue, only the normalization is needed
+  sum_persistence = h.sum_persistence;
+  queue_flag = false;
+  //! cancel() is deterministic, so the prefix reproduces the recorded run
+  size_t prefix = h.getPrefixSize(threshold);
+  size_t mismatch = 0;
+  for(size_t k=0; k<prefix; ++k){
+    const PersistenceHierarchy::Cancellation& c = h.cancel_vec[k];
+    if(c.il_index < 0 || c.il_index >= (int)il_vec.size()){ ++mismatch; continue; }
+    if(cancel(c.il_index) != c.cancelled) ++mismatch;
+  }
+  endSimplify();
+  queue_flag = true;
+  if(mismatch != 0){
+    cerr << "Warning: " << mismatch << " cancellations do not match the persistence hierarchy" << endl;
+    return false;
+  }
+  return true;
+}
+
+void Simplifor::beginSimplify(double threshold){
+  cancel_threshold = threshold;
+  removed_il_flag.clear(); removed_il_flag.resize(il_vec.size(), false);
+  removed_cp_flag.clear(); removed_cp_flag.resize(cp_vec.size(), false);
+  storePath();
+}
+
+void Simplifor::endSimplify(){
   if(remove_deg_sad)
     removeDegenerateSaddle();
 
@@ -55,6 +106,7 @@ void Simplifor::simplify(double threshold){
     if(cp_vec[i].neighbor.size() == 0) removed_cp_flag[i] = true;
   }
   
+  restorePath();
   update();
   refinePath();
 }
@@ -82,9 +134,9 @@ bool Simplifor::cancel(int cancelIL_index){
   int bridgeIL_index;
   int next_il_index1 = s.neighbor[(cancel_nb_idx+1)%s.neighbor.size()].integrationLineIndex;
   int next_il_index2 = s.neighbor[(cancel_nb_idx+2)%s.neighbor.size()].integrationLineIndex;
-  bool is_ascending_il1 = isAscendingIL(il_vec[cancelIL_index]);
-  bool is_ascending_il2 = isAscendingIL(il_vec[next_il_index1]);
-  bool is_ascending_il3 = isAscendingIL(il_vec[next_il_index2]);
+  bool is_ascending_il1 = isAscendingIL(cancelIL_index);
+  bool is_ascending_il2 = isAscendingIL(next_il_index1);
+  bool is_ascending_il3 = isAscendingIL(next_il_index2);
   if(is_ascending_il1 == is_ascending_il2) bridgeIL_index = next_il_index1; // at boundary
   else if(is_ascending_il1 == is_ascending_il3) bridgeIL_index = next_il_index2;
   else{ // at boundary
@@ -153,24 +205,34 @@ void Simplifor::transferConnection(int cp1_idx, int cp2_idx, int il1_idx, int il
     ++nb_il_idx2;
   }
   
-  // make new path
-  PATH ext_path = il_vec[il1_idx].path; ext_path.pop_back();
-  reverse(ext_path.begin(), ext_path.end()); 
-  ext_path.insert(ext_path.end(), il_vec[il2_idx].path.begin()+1, il_vec[il2_idx].path.end());
+  if(recorder){
+    PersistenceHierarchy::Cancellation& c = recorder->cancel_vec.back();
+    c.target = cp2_idx;
+    c.rerouted_first = recorder->rerouted_vec.size();
+  }
+
+  // make new path, il1 backward without cp1 then il2 without the saddle.
+  // only a join is recorded, the paths are built for the survivors in restorePath
+  int ext_join = path_store.addJoin(il1_idx, il2_idx);
   
   for(size_t i=0; i<nb1.size(); ++i){
     int il_idx = nb1[i].integrationLineIndex;
     if(il_idx == il1_idx) continue;
     IntegrationLine& il = il_vec[il_idx];
-    il.path.insert(il.path.end(), ext_path.begin(),  ext_path.end());
+    path_store.appendJoin(il_idx, ext_join);
     il.endIndex = cp2_idx;
+    if(recorder) recorder->rerouted_vec.push_back(il_idx);
+    if(!queue_flag) continue;
 
     double new_ps = msc.calPersistence(il.startIndex, il.endIndex)/sum_persistence;
-    if(new_ps <= cancel_threshold ) persistence_map[il_idx] = new_ps;
-    else{
-      map<size_t, double>::iterator iter = persistence_map.find(il_idx);
-      if(iter != persistence_map.end()) persistence_map.erase(iter);
-    }
+    if(new_ps <= cancel_threshold ){
+      if(persistence_heap.contains(il_idx)) persistence_heap.update(il_idx, make_pair(new_ps, il_idx));
+      else persistence_heap.push(il_idx, make_pair(new_ps, il_idx));
+    }else if(persistence_heap.contains(il_idx)) persistence_heap.erase(il_idx);
+  }
+  if(recorder){
+    PersistenceHierarchy::Cancellation& c = recorder->cancel_vec.back();
+    c.rerouted_num = recorder->rerouted_vec.size() - c.rerouted_first;
   }
 }
 
@@ -200,30 +262,46 @@ void Simplifor::update(){
   for(size_t i=0; i<il_vec.size(); ++i)
     if(!removed_il_flag[i]) il_index_mapping[i] = il_index++;
 
-  //! update neighbor
+  //! remove critial points and integration lines in place, element i
+  //! moves down to its new index. the vectors are swapped, not copied
   for(size_t i=0; i<cp_vec.size(); ++i){
+    int j = cp_index_mapping[i];
+    if(removed_cp_flag[i] || j == (int)i) continue;
+    cp_vec[j].type = cp_vec[i].type;
+    cp_vec[j].meshIndex = cp_vec[i].meshIndex;
+    cp_vec[j].neighbor.swap(cp_vec[i].neighbor);
+  }
+  cp_vec.resize(cp_index);
+  for(size_t i=0; i<il_vec.size(); ++i){
+    int j = il_index_mapping[i];
+    if(removed_il_flag[i] || j == (int)i) continue;
+    il_vec[j].startIndex = il_vec[i].startIndex;
+    il_vec[j].endIndex = il_vec[i].endIndex;
+    il_vec[j].quadPatchIndex.swap(il_vec[i].quadPatchIndex);
+    il_vec[j].path.swap(il_vec[i].path);
+  }
+  il_vec.resize(il_index);
+
+  //! update neighbor
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int i=0; i<cp_index; ++i){
     CriticalPointNeighborArray& nb = cp_vec[i].neighbor;
     for(size_t k=0; k<nb.size(); ++k){
       nb[k].pointIndex = cp_index_mapping[nb[k].pointIndex];
       nb[k].integrationLineIndex = il_index_mapping[nb[k].integrationLineIndex];
     }
   }
-  for(size_t i=0; i<il_vec.size(); ++i){
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int i=0; i<il_index; ++i){
     IntegrationLine& il = il_vec[i];
     il.startIndex = cp_index_mapping[il.startIndex];
     il.endIndex = cp_index_mapping[il.endIndex];
   }
 
-  //! remove critial points and integration lines
-  CriticalPointArray new_cp_vec;
-  for(size_t i=0; i<cp_vec.size(); ++i)
-    if(!removed_cp_flag[i]) new_cp_vec.push_back(cp_vec[i]);
-  swap(cp_vec, new_cp_vec);
-  IntegrationLineArray new_il_vec;
-  for(size_t i=0; i<il_vec.size(); ++i)
-    if(!removed_il_flag[i]) new_il_vec.push_back(il_vec[i]);
-  swap(il_vec, new_il_vec);
-
   fill(msc.vert_cp_index_mp.begin(), msc.vert_cp_index_mp.end(), -1);
   for(size_t k=0; k<cp_vec.size(); ++k){
     msc.vert_cp_index_mp[cp_vec[k].meshIndex] = k;
@@ -231,17 +309,51 @@ void Simplifor::update(){
 
 }
 
-void Simplifor::refinePath(){
-  //! remove circle
+void Simplifor::storePath(){
+  //! move the paths into the store, lines merging into one extremum
+  //! keep their common suffix once
+  path_store.clear();
+  ascending_flag.resize(il_vec.size());
   for(size_t i=0; i<il_vec.size(); ++i){
-    PATH& path  = il_vec[i].path;
-    for(size_t k=0; k<path.size(); ++k){
-      for(size_t j=path.size()-1; j!=k; --j){
-        if(path[j] == path[k]){
-          path.erase(path.begin()+k+1, path.begin()+j+1);
-          break;
-        }
-      }
+    PATH& path = il_vec[i].path;
+    ascending_flag[i] = msc.cmpScalarValue(path[0], path[1]) == 1;
+    path_store.addPath(path);
+    PATH().swap(path);
+  }
+}
+
+void Simplifor::restorePath(){
+  //! materialize the lines which survive the simplification
+  int il_num = il_vec.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for(int i=0; i<il_num; ++i)
+    if(!removed_il_flag[i]) path_store.getPath(i, il_vec[i].path);
+  path_store.clear();
+}
+
+void Simplifor::refinePath(){
+  //! remove circle: keep a vertex, then jump past its last occurrence.
+  //! last_pos is filled for every vertex of the path before it is read,
+  //! so the scratch array is never cleared between paths
+  int il_num = il_vec.size();
+  int vert_num = msc.mesh->getVertexNumber();
+#ifdef _OPENMP
+#pragma omp parallel if(il_num > 1)
+#endif
+  {
+    vector<int> last_pos(vert_num);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+    for(int i=0; i<il_num; ++i){
+      PATH& path = il_vec[i].path;
+      int len = path.size();
+      for(int k=0; k<len; ++k) last_pos[path[k]] = k;
+      int new_len = 0;
+      for(int k=0; k<len; k = last_pos[path[k]]+1) path[new_len++] = path[k];
+      path.resize(new_len);
     }
   }
 }
@@ -253,9 +365,8 @@ int Simplifor::getILIndexInNeighbor(const CriticalPoint& cb, int il_index) const
   return -1;
 }
 
-bool Simplifor::isAscendingIL(const IntegrationLine& il) const{
-  int vid1 = il.path[0], vid2 = il.path[1];
-  return msc.cmpScalarValue(vid1, vid2) == 1;
+bool Simplifor::isAscendingIL(int il_index) const{
+  return ascending_flag[il_index];
 }
 
 void Simplifor::removeDegenerateSaddle(){
@@ -5,6 +5,9 @@
 #include <set>
 #include <iostream>
 #include "mscomplex.h"
+#include "path_store.h"
+#include "persistence_hierarchy.h"
+#include "../util/indexed_heap.h"
 
 namespace msc2d{
   
@@ -29,16 +32,30 @@ namespace msc2d{
     ~Simplifor();
 
     void simplify(double threshold = 0.003);
+    /*
+      record the cancellations of simplify(max_threshold) into h. the
+      complex is left partly simplified, the caller restores the traced one
+    */
+    void recordHierarchy(double max_threshold, PersistenceHierarchy& h);
+    //! simplify(threshold) of the traced complex h was recorded from,
+    //! replaying a prefix of h instead of searching the queue
+    bool replayHierarchy(const PersistenceHierarchy& h, double threshold);
+    //! normalization of the persistence, from the current lines
+    double calSumPersistence() const;
  private:
+    void beginSimplify(double threshold);
+    void endSimplify();
     void calPersistence();
     bool cancel(int cancelIL_index);
     void transferConnection(int cp1_idx, int cp2_idx, int il1_idx, int il2_idx);
     void removeSad(int cp_index);
     bool removePersPair(int il_index);
     void update();
+    void storePath();
+    void restorePath();
     void refinePath();
     int getILIndexInNeighbor(const CriticalPoint& cp, int il_index) const;
-    bool isAscendingIL(const IntegrationLine& il) const;
+    bool isAscendingIL(int il_index) const;
     void removeDegenerateSaddle();
     bool isDegenerateSaddle(const CriticalPoint& cp) const;
  private:
@@ -47,11 +64,20 @@ namespace msc2d{
     IntegrationLineArray& il_vec;
     
     double cancel_threshold;
-    std::map<size_t, double> persistence_map;
+    //! lines below the threshold keyed by (persistence, line index), so
+    //! the lowest persistence is cancelled first and ties by line index
+    meshlib::IndexedHeap< std::pair<double, int> > persistence_heap;
     std::vector<int> removed_il_flag;
     std::vector<int> removed_cp_flag;
+    //! paths of il_vec while simplifying, line k is il_vec[k]
+    PathStore path_store;
+    std::vector<bool> ascending_flag;
     double sum_persistence;
     bool remove_deg_sad;
+    //! hierarchy being recorded, NULL if not recording
+    PersistenceHierarchy* recorder;
+    //! false while replaying a hierarchy, persistence_heap is then unused
+    bool queue_flag;
   };
 }
 
@@ -4,23 +4,75 @@
 #include "quad_patch_generator.h"
 #include "msc2d_simplification.h"
 #include "dual_mscomplex_generator.h"
+#include "scalar_field_io.h"
 #include "../mesh/Mesh.h"
 #include "../common/macro.h"
 #include <fstream>
 #include <limits>
+#include <algorithm>
 #include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace meshlib;
 
 namespace msc2d{
 
-MSComplex2D::MSComplex2D(){}
+//! batch outputs are written as a single run of the msc2d tool writes
+//! them, with operator << (saveMSComplex leaves out the patches)
+static bool writeMSComplex(const MSComplex2D& msc, const string& file_name){
+  ofstream os(file_name.c_str());
+  if(!os) {
+    cerr << "Cannot open " << file_name << endl;
+    return false;
+  }
+  cout << "Save to " << file_name << endl;
+  os << msc;
+  return true;
+}
+
+MSComplex2D::MSComplex2D(): grad_cache_flag(false), path_search_mode(SEARCH_DIJKSTRA){}
 MSComplex2D::~MSComplex2D(){}
 
+//! the tracer refers to its owner, so it is never shared between copies
+MSComplex2D::MSComplex2D(const MSComplex2D& rhs):
+    mesh(rhs.mesh), scalar_field(rhs.scalar_field), cp_vec(rhs.cp_vec),
+    il_vec(rhs.il_vec), qp_vec(rhs.qp_vec), dp_vec(rhs.dp_vec),
+    vert_rank_vec(rhs.vert_rank_vec), upper_link_vec(rhs.upper_link_vec),
+    upper_link_offset(rhs.upper_link_offset), grad_cache_flag(rhs.grad_cache_flag),
+    slot_grad_vec(rhs.slot_grad_vec), vert_cp_index_mp(rhs.vert_cp_index_mp),
+    path_search_mode(rhs.path_search_mode), traced_cp_vec(rhs.traced_cp_vec),
+    traced_il_vec(rhs.traced_il_vec), traced_vert_cp_index_mp(rhs.traced_vert_cp_index_mp),
+    hierarchy(rhs.hierarchy){}
+
+MSComplex2D& MSComplex2D::operator = (const MSComplex2D& rhs){
+  if(this == &rhs) return *this;
+  if(mesh != rhs.mesh) il_tracer.reset();
+  mesh = rhs.mesh; scalar_field = rhs.scalar_field;
+  cp_vec = rhs.cp_vec; il_vec = rhs.il_vec;
+  qp_vec = rhs.qp_vec; dp_vec = rhs.dp_vec;
+  vert_rank_vec = rhs.vert_rank_vec;
+  upper_link_vec = rhs.upper_link_vec;
+  upper_link_offset = rhs.upper_link_offset;
+  grad_cache_flag = rhs.grad_cache_flag;
+  slot_grad_vec = rhs.slot_grad_vec;
+  vert_cp_index_mp = rhs.vert_cp_index_mp;
+  path_search_mode = rhs.path_search_mode;
+  traced_cp_vec = rhs.traced_cp_vec;
+  traced_il_vec = rhs.traced_il_vec;
+  traced_vert_cp_index_mp = rhs.traced_vert_cp_index_mp;
+  hierarchy = rhs.hierarchy;
+  return *this;
+}
+
 bool MSComplex2D::setMesh(const string& file_name){
-  mesh = boost::shared_ptr<Mesh>(new Mesh);
-  if(!mesh->attachModel(file_name)){
+  il_tracer.reset();
+  clearPersistenceHierarchy();
+  boost::shared_ptr<Mesh> p_mesh(new Mesh);
+  mesh = p_mesh;
+  if(!p_mesh->attachModel(file_name)){
     cerr << "cannot attach model" << endl;
     return false;
   }else{
@@ -37,33 +89,22 @@ bool MSComplex2D::setMesh(const string& file_name){
   return true;
 }
 
-bool MSComplex2D::setScalarField(const string& file_name){
-  ifstream fin(file_name.c_str());
-  if(fin.fail()){
-    //! TODO:
-    cerr << "Cannot load scalar field file " << file_name << endl;
-    return false;
-  }
-
-  scalar_field.clear(); 
-  size_t vert_num;
-  fin >> vert_num;
-
-  double scalar;
-  while(fin >> scalar){
-    scalar_field.push_back(scalar);
-  }
+bool MSComplex2D::setMesh(boost::shared_ptr<const Mesh> p_mesh){
+  il_tracer.reset();
+  clearPersistenceHierarchy();
+  mesh = p_mesh;
+  return mesh != NULL;
+}
 
-  if(scalar_field.size() != vert_num){
-    //! TODO:
-    cerr << "Warning : " << endl;
-  }
-  
-  fin.close();
-  return true;
+bool MSComplex2D::setScalarField(const string& file_name){
+  clearPersistenceHierarchy();
+  if(isBinaryScalarFieldFile(file_name))
+    return loadScalarFieldBinary(file_name, scalar_field);
+  return loadScalarFieldText(file_name, scalar_field);
 }
 
 bool MSComplex2D::setScalarField(const vector<double>& _scalar_file){
+  clearPersistenceHierarchy();
   scalar_field = _scalar_file;
   return true;
 }
@@ -72,13 +113,7 @@ bool MSComplex2D::createMSComplex2D(double threshold /*=0.003*/){
   if(!checkMeshAndScalarField()){
     return false;
   }
-
-  CPFinder cp_finder(*this);
-  cp_finder.findCriticalPoints();
-  cp_finder.printCriticalPointsInfo();
-
-  ILTracer il_tracer(*this);
-  il_tracer.traceIntegrationLine();
+  traceMSComplex2D();
 
 //  Simplifor simplifor(*this, true);
 //  simplifor.simplify(threshold);
@@ -89,18 +124,108 @@ bool MSComplex2D::createMSComplex2D(double threshold /*=0.003*/){
   return true;
 }
 
-bool MSComplex2D::createDualMSComplex2D(const string& file_name, double threshold /*=0.003*/) {
+bool MSComplex2D::createPersistenceHierarchy(double max_threshold /*=0.1*/){
   if(!checkMeshAndScalarField()){
     return false;
   }
+  traceMSComplex2D();
+  keepTracedComplex();
+
+  Simplifor simplifor(*this, true);
+  simplifor.recordHierarchy(max_threshold, hierarchy);
+  restoreTracedComplex();
+  return true;
+}
+
+bool MSComplex2D::queryMSComplex2D(double threshold){
+  if(hierarchy.empty() || traced_cp_vec.empty()){
+    cerr << "Error: please create the persistence hierarchy first!" << endl;
+    return false;
+  }
+  if(threshold > hierarchy.max_threshold){
+    cerr << "Error: threshold " << threshold << " is above the recorded "
+         << hierarchy.max_threshold << endl;
+    return false;
+  }
+  restoreTracedComplex();
+  Simplifor simplifor(*this, true);
+  return simplifor.replayHierarchy(hierarchy, threshold);
+}
+
+bool MSComplex2D::savePersistenceHierarchy(const string& file_name) const{
+  if(hierarchy.empty()){
+    cerr << "Error: no persistence hierarchy to save" << endl;
+    return false;
+  }
+  cout << "Save persistence hierarchy to " << file_name << endl;
+  return hierarchy.save(file_name);
+}
+
+bool MSComplex2D::loadPersistenceHierarchy(const string& file_name){
+  if(!checkMeshAndScalarField()){
+    return false;
+  }
+  if(traced_cp_vec.empty()){
+    traceMSComplex2D();
+    keepTracedComplex();
+  }else restoreTracedComplex();
+  if(!hierarchy.load(file_name)) return false;
+  //! the thresholds are compared on the normalization of the traced complex
+  double sum_persistence = Simplifor(*this, true).calSumPersistence();
+  if(fabs(hierarchy.sum_persistence - sum_persistence) > 1e-9*sum_persistence){
+    cerr << "Error: " << file_name << " was recorded with another persistence normalization" << endl;
+    hierarchy.clear();
+    return false;
+  }
+  //! the record refers to the lines of the traced complex
+  for(size_t k=0; k<hierarchy.cancel_vec.size(); ++k){
+    const PersistenceHierarchy::Cancellation& c = hierarchy.cancel_vec[k];
+    if(c.il_index < 0 || c.il_index >= (int)traced_il_vec.size() ||
+       traced_il_vec[c.il_index].startIndex != c.saddle){
+      cerr << "Error: " << file_name << " does not match the traced complex" << endl;
+      hierarchy.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void MSComplex2D::traceMSComplex2D(){
   cp_vec.clear(); il_vec.clear(); qp_vec.clear();
 
   CPFinder cp_finder(*this);
   cp_finder.findCriticalPoints();
   cp_finder.printCriticalPointsInfo();
 
-  ILTracer il_tracer(*this);
-  il_tracer.traceIntegrationLine();
+  if(!il_tracer) il_tracer.reset(new ILTracer(*this));
+  il_tracer->traceIntegrationLine();
+}
+
+void MSComplex2D::keepTracedComplex(){
+  traced_cp_vec = cp_vec;
+  traced_il_vec = il_vec;
+  traced_vert_cp_index_mp = vert_cp_index_mp;
+}
+
+void MSComplex2D::restoreTracedComplex(){
+  cp_vec = traced_cp_vec;
+  il_vec = traced_il_vec;
+  vert_cp_index_mp = traced_vert_cp_index_mp;
+  qp_vec.clear(); dp_vec.clear();
+}
+
+void MSComplex2D::clearPersistenceHierarchy(){
+  traced_cp_vec.clear();
+  traced_il_vec.clear();
+  traced_vert_cp_index_mp.clear();
+  hierarchy.clear();
+}
+
+bool MSComplex2D::createDualMSComplex2D(const string& file_name, double threshold /*=0.003*/) {
+  if(!checkMeshAndScalarField()){
+    return false;
+  }
+  traceMSComplex2D();
 
   Simplifor simplifor(*this, true);
   simplifor.simplify(threshold);
@@ -117,24 +242,121 @@ bool MSComplex2D::createDualMSComplex2D(const string& file_name, double threshol
   return true;
 }
 
-int MSComplex2D::cmpScalarValue(int vid1, int vid2) const{
-  if( fabs(scalar_field[vid1] - scalar_field[vid2]) < LARGE_ZERO_EPSILON ){
-    int pri_1 = vert_priority_mp.find(vid1)->second;
-    int pri_2 = vert_priority_mp.find(vid2)->second;
-    assert(pri_1 != pri_2);
-    return (pri_1 > pri_2) ? 1 : -1;
-  }else{
-    return scalar_field[vid1] > scalar_field[vid2] ? 1 : -1;
+bool MSComplex2D::createMSComplex2DBatch(const vector<string>& sf_files,
+                                         const vector<string>& msc_files,
+                                         double threshold /*=0.003*/){
+  if(sf_files.size() != msc_files.size()){
+    cerr << "Error: " << sf_files.size() << " scalar fields but "
+         << msc_files.size() << " output files" << endl;
+    return false;
+  }
+  bool ok = true;
+  for(size_t k=0; k<sf_files.size(); ++k){
+    cout << "Field " << k+1 << "/" << sf_files.size() << " : " << sf_files[k] << endl;
+    if(!setScalarField(sf_files[k]) || !createMSComplex2D(threshold) ||
+       !writeMSComplex(*this, msc_files[k])) ok = false;
+  }
+  return ok;
+}
+
+bool MSComplex2D::createMSComplex2DBatch(const vector< vector<double> >& fields,
+                                         const vector<string>& msc_files,
+                                         double threshold /*=0.003*/){
+  if(fields.size() != msc_files.size()){
+    cerr << "Error: " << fields.size() << " scalar fields but "
+         << msc_files.size() << " output files" << endl;
+    return false;
+  }
+  bool ok = true;
+  for(size_t k=0; k<fields.size(); ++k){
+    cout << "Field " << k+1 << "/" << fields.size() << endl;
+    //! assign keeps the capacity of the previous field
+    clearPersistenceHierarchy();
+    scalar_field.assign(fields[k].begin(), fields[k].end());
+    if(!createMSComplex2D(threshold) || !writeMSComplex(*this, msc_files[k])) ok = false;
+  }
+  return ok;
+}
+
+bool createMSComplex2DParallel(boost::shared_ptr<const Mesh> mesh,
+                               const vector<string>& sf_files,
+                               const vector<string>& msc_files,
+                               double threshold /*=0.003*/, int thread_num /*=0*/){
+  if(sf_files.size() != msc_files.size()){
+    cerr << "Error: " << sf_files.size() << " scalar fields but "
+         << msc_files.size() << " output files" << endl;
+    return false;
   }
+  int field_num = sf_files.size();
+  vector<char> field_ok(field_num, 0);
+#ifdef _OPENMP
+  if(thread_num <= 0) thread_num = omp_get_max_threads();
+#pragma omp parallel num_threads(thread_num)
+#endif
+  {
+    MSComplex2D msc;
+    msc.setMesh(mesh);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for(int k=0; k<field_num; ++k){
+      field_ok[k] = msc.setScalarField(sf_files[k]) && msc.createMSComplex2D(threshold) &&
+          writeMSComplex(msc, msc_files[k]);
+    }
+  }
+  return find(field_ok.begin(), field_ok.end(), 0) == field_ok.end();
+}
+
+bool createMSComplex2DParallel(boost::shared_ptr<const Mesh> mesh,
+                               const vector< vector<double> >& fields,
+                               const vector<string>& msc_files,
+                               double threshold /*=0.003*/, int thread_num /*=0*/){
+  if(fields.size() != msc_files.size()){
+    cerr << "Error: " << fields.size() << " scalar fields but "
+         << msc_files.size() << " output files" << endl;
+    return false;
+  }
+  int field_num = fields.size();
+  vector<char> field_ok(field_num, 0);
+#ifdef _OPENMP
+  if(thread_num <= 0) thread_num = omp_get_max_threads();
+#pragma omp parallel num_threads(thread_num)
+#endif
+  {
+    MSComplex2D msc;
+    msc.setMesh(mesh);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for(int k=0; k<field_num; ++k){
+      field_ok[k] = msc.setScalarField(fields[k]) && msc.createMSComplex2D(threshold) &&
+          writeMSComplex(msc, msc_files[k]);
+    }
+  }
+  return find(field_ok.begin(), field_ok.end(), 0) == field_ok.end();
 }
 
 double MSComplex2D::calGradient(int vid1, int vid2) const{
   if(vid1 == vid2) return 0.0;
   const Coord3D& coord1 = mesh->getVertexCoord(vid1);
   const Coord3D& coord2 = mesh->getVertexCoord(vid2);
-  double dis = (coord1-coord2).abs();
-  if(dis < LARGE_ZERO_EPSILON) return numeric_limits<double>::infinity();
-  return (scalar_field[vid1] - scalar_field[vid2])/dis;
+  return calGradient(vid1, vid2, (coord1-coord2).abs());
+}
+
+void MSComplex2D::genSlotGradient(){
+  if(!grad_cache_flag) { slot_grad_vec.clear(); return; }
+  int vert_num = mesh->getVertexNumber();
+  slot_grad_vec.resize(mesh->getAdjSlotOffset(vert_num));
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for(int vid=0; vid<vert_num; ++vid){
+    VertHandleSpan adj_vertices = mesh->getAdjVertices(vid);
+    DoubleSpan edge_len = mesh->getAdjEdgeLengths(vid);
+    double* grad = &slot_grad_vec[0] + mesh->getAdjSlotOffset(vid);
+    for(size_t k=0; k<adj_vertices.size(); ++k)
+      grad[k] = calGradient(vid, adj_vertices[k], edge_len[k]);
+  }
 }
 
 CriticalPointType MSComplex2D::getVertexType(int vid) const{
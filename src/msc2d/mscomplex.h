@@ -6,12 +6,17 @@
 #include <map>
 #include <fstream>
 #include <boost/shared_ptr.hpp>
+#include "upper_link.h"
+#include "persistence_hierarchy.h"
+#include "../common/macro.h"
+#include <limits>
 
 namespace meshlib{
   class Mesh;
 }
 
 namespace msc2d{
+  class ILTracer;
 
   struct CriticalPointNeighbor {
     int pointIndex;  //the index into critical point array
@@ -56,10 +61,13 @@ namespace msc2d{
 
  public:
     MSComplex2D();
+    MSComplex2D(const MSComplex2D&);
     ~MSComplex2D();
+    MSComplex2D& operator = (const MSComplex2D&);
     
     bool setMesh(const std::string& file_name);
-    bool setMesh(boost::shared_ptr<meshlib::Mesh> p_mesh);
+    //! the mesh is only read, so one mesh can be shared by many complexes
+    bool setMesh(boost::shared_ptr<const meshlib::Mesh> p_mesh);
     bool setScalarField(const std::string& file_name);
     bool setScalarField(const std::vector<double>& sf);
 
@@ -71,18 +79,72 @@ namespace msc2d{
 
     bool createDualMSComplex2D(const std::string& file_name,
                                double threshold = 0.003);
+
+    /*
+      Persistence hierarchy: trace once, record every cancellation up to
+      max_threshold, then queryMSComplex2D(t) gives the complex simplified
+      at any t <= max_threshold by replaying a prefix of the record, without
+      tracing again. The traced complex is kept for the queries.
+    */
+    bool createPersistenceHierarchy(double max_threshold = 0.1);
+    bool queryMSComplex2D(double threshold);
+    bool savePersistenceHierarchy(const std::string& file_name) const;
+    //! traces the complex first if it is not kept yet, the complex is
+    //! the traced one afterwards
+    bool loadPersistenceHierarchy(const std::string& file_name);
+
+    /*
+      keep the directed gradient of every one-ring slot for the current
+      field, filled before tracing. costs one double per half edge
+    */
+    void setGradientCache(bool flag) { grad_cache_flag = flag; }
+
+    //! shortest path strategy of the patch generators, see meshlib::PATHSEARCHMODE.
+    //! SEARCH_ASTAR settles far fewer vertices but may pick another path of equal length
+    void setPathSearchMode(int mode) { path_search_mode = mode; }
+
+    /*
+      Batch mode: the mesh is attached once, then one complex is created
+      and saved per scalar field. Mesh topology and the tracer scratch
+      buffers are reused between fields.
+      @param sf_files / fields: scalar field files or in-memory fields
+      @param msc_files: output .msc file of each field, same format as a single run
+    */
+    bool createMSComplex2DBatch(const std::vector<std::string>& sf_files,
+                                const std::vector<std::string>& msc_files,
+                                double threshold = 0.003);
+    bool createMSComplex2DBatch(const std::vector< std::vector<double> >& fields,
+                                const std::vector<std::string>& msc_files,
+                                double threshold = 0.003);
  private:
     /*
-      Compair two vertices' scalar
-      @return 1: v1>v2; -1: v1<v2; 0:v1==v2
+      Compair two vertices' scalar through their rank
+      @return 1: v1>v2; -1: v1<v2
     */
-    int cmpScalarValue(int vert_1, int vert_2) const;
+    int cmpScalarValue(int vert_1, int vert_2) const {
+      return vert_rank_vec[vert_1] > vert_rank_vec[vert_2] ? 1 : -1;
+    }
+    //! upper link bitmask of a vertex, see upper_link.h
+    const LinkWord* getUpperLink(int vid) const {
+      return &upper_link_vec[upper_link_offset[vid]];
+    }
     double calGradient(int vert_1, int vert_2) const;
+    //! calGradient with the distance of the two vertices known
+    double calGradient(int vert_1, int vert_2, double dis) const {
+      if(vert_1 == vert_2) return 0.0;
+      if(dis < meshlib::LARGE_ZERO_EPSILON) return std::numeric_limits<double>::infinity();
+      return (scalar_field[vert_1] - scalar_field[vert_2])/dis;
+    }
+    void genSlotGradient();
     double calPersistence(int cp1_index, int cp2_index) const;
     CriticalPointType getVertexType(int vid) const;
+    void traceMSComplex2D();
+    void keepTracedComplex();
+    void restoreTracedComplex();
+    void clearPersistenceHierarchy();
     
  private:
-    boost::shared_ptr<meshlib::Mesh> mesh;
+    boost::shared_ptr<const meshlib::Mesh> mesh;
     std::vector<double> scalar_field;
 
     CriticalPointArray cp_vec;
@@ -90,11 +152,32 @@ namespace msc2d{
     QuadPatchArray qp_vec; // primal patch array
     QuadPatchArray dp_vec; // dual patch array
 
-    // vertex priority for flat region
-    std::map<int, int> vert_priority_mp;
+    // vertex index -> rank in the total order of the scalar field,
+    // flat regions are ordered by their breadth first traversal
+    std::vector<unsigned int> vert_rank_vec;
+    // upper link bitmasks of all vertices, the words of vertex v start at
+    // upper_link_offset[v]
+    std::vector<LinkWord> upper_link_vec;
+    std::vector<int> upper_link_offset;
+    // calGradient(v, k-th neighbor of v) at Mesh::getAdjSlotOffset(v)+k,
+    // empty unless grad_cache_flag is set
+    bool grad_cache_flag;
+    std::vector<double> slot_grad_vec;
     // vertex index -> critical point index mapping
     std::vector<int> vert_cp_index_mp;
 
+    // integration line tracer kept between runs to reuse its buffers,
+    // bound to this complex and its mesh
+    boost::shared_ptr<ILTracer> il_tracer;
+    int path_search_mode;
+
+    // traced complex before simplification and its cancellation record,
+    // empty until createPersistenceHierarchy
+    CriticalPointArray traced_cp_vec;
+    IntegrationLineArray traced_il_vec;
+    std::vector<int> traced_vert_cp_index_mp;
+    PersistenceHierarchy hierarchy;
+
     friend class CPFinder;
     friend class ILTracer;
     friend class Simplifor;
@@ -108,6 +191,21 @@ namespace msc2d{
   std::istream & operator >> (std::istream&, MSComplex2D&);
   std::ostream & operator << (std::ostream&, const MSComplex2D&);
 
+  /*
+    Compute the complexes of several scalar fields concurrently over one
+    shared read-only mesh. Every worker thread owns one MSComplex2D and
+    reuses it for the fields it picks up.
+    @param thread_num: number of workers, 0 uses the OpenMP default
+  */
+  bool createMSComplex2DParallel(boost::shared_ptr<const meshlib::Mesh> mesh,
+                                 const std::vector<std::string>& sf_files,
+                                 const std::vector<std::string>& msc_files,
+                                 double threshold = 0.003, int thread_num = 0);
+  bool createMSComplex2DParallel(boost::shared_ptr<const meshlib::Mesh> mesh,
+                                 const std::vector< std::vector<double> >& fields,
+                                 const std::vector<std::string>& msc_files,
+                                 double threshold = 0.003, int thread_num = 0);
+
   bool operator == (const CriticalPointNeighbor& lhs, const CriticalPointNeighbor& rhs);
 }// end namespace
 
@@ -0,0 +1,144 @@
+#include "path_store.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+namespace msc2d{
+
+PathStore::PathStore(){ clear(); }
+PathStore::~PathStore(){}
+
+void PathStore::clear(){
+  vert_pool.clear();
+  run_offset.assign(1, 0);
+  line_vec.clear();
+  join_vec.clear();
+  vert_pos_vec.clear();
+}
+
+int PathStore::addRun(const PATH& path, size_t first, size_t last){
+  int run = (int)run_offset.size()-1;
+  for(size_t i=first; i<last; ++i){
+    int vid = path[i];
+    if(vid >= (int)vert_pos_vec.size()) vert_pos_vec.resize(vid+1, make_pair(-1, 0));
+    if(vert_pos_vec[vid].first == -1) vert_pos_vec[vid] = make_pair(run, (int)(i-first));
+    vert_pool.push_back(vid);
+  }
+  run_offset.push_back((int)vert_pool.size());
+  return run;
+}
+
+int PathStore::addPath(const PATH& path){
+  line_vec.push_back(Line());
+  Line& line = line_vec.back();
+  line.seg_size = path.size();
+  //! the first vertex whose stored run continues exactly as the path
+  size_t shared = path.size();
+  Segment tail = {-1, 0, 0};
+  for(size_t i=0; i<path.size() && shared == path.size(); ++i){
+    int vid = path[i];
+    if(vid >= (int)vert_pos_vec.size() || vert_pos_vec[vid].first == -1) continue;
+    int run = vert_pos_vec[vid].first, pos = vert_pos_vec[vid].second;
+    if(getRunSize(run) - pos != (int)(path.size() - i)) continue;
+    if(!equal(path.begin()+i, path.end(), vert_pool.begin() + run_offset[run] + pos)) continue;
+    shared = i;
+    tail.run = run; tail.first = pos; tail.last = getRunSize(run)-1;
+  }
+  if(shared > 0){
+    Segment head = {addRun(path, 0, shared), 0, (int)shared-1};
+    line.segs.push_back(head);
+  }
+  if(tail.run != -1) line.segs.push_back(tail);
+  return (int)line_vec.size()-1;
+}
+
+int PathStore::addJoin(int line1, int line2){
+  Join join;
+  join.line1 = line1; join.join_num1 = line_vec[line1].join_vec.size();
+  join.line2 = line2; join.join_num2 = line_vec[line2].join_vec.size();
+  join.size = getPathSize(line1) - 1 + getPathSize(line2) - 1;
+  join_vec.push_back(join);
+  return (int)join_vec.size()-1;
+}
+
+void PathStore::appendJoin(int line, int join){
+  LineJoin line_join = {join, getPathSize(line) + join_vec[join].size};
+  line_vec[line].join_vec.push_back(line_join);
+}
+
+PathStore::Piece PathStore::makePiece(PIECEKIND kind, int index, int join_num, bool reversed) const{
+  Piece piece = {kind, index, join_num, reversed, 0, 0, 0};
+  if(kind == PIECE_SEGMENTS) piece.size = line_vec[index].seg_size;
+  else if(kind == PIECE_LINE) piece.size = getPathSize(index, join_num);
+  else piece.size = join_vec[index].size;
+  return piece;
+}
+
+void PathStore::splitPiece(const Piece& piece, PieceArray& parts) const{
+  parts.clear();
+  //! the parts of the forward piece first
+  if(piece.kind == PIECE_LINE){
+    const Line& line = line_vec[piece.index];
+    parts.push_back(makePiece(PIECE_SEGMENTS, piece.index, 0, false));
+    for(int k=0; k<piece.join_num; ++k)
+      parts.push_back(makePiece(PIECE_JOIN, line.join_vec[k].join, 0, false));
+  }else{
+    //! line1 backward, its last vertex comes first and is dropped,
+    //! then line2 without its first vertex
+    const Join& join = join_vec[piece.index];
+    parts.push_back(makePiece(PIECE_LINE, join.line1, join.join_num1, true));
+    parts.push_back(makePiece(PIECE_LINE, join.line2, join.join_num2, false));
+    for(size_t k=0; k<parts.size(); ++k) { parts[k].skip_front = 1; --parts[k].size; }
+  }
+  if(piece.reversed){
+    reverse(parts.begin(), parts.end());
+    for(size_t k=0; k<parts.size(); ++k){
+      parts[k].reversed = !parts[k].reversed;
+      swap(parts[k].skip_front, parts[k].skip_back);
+    }
+  }
+
+  size_t skip = piece.skip_front;
+  for(size_t k=0; k<parts.size() && skip > 0; ++k){
+    size_t n = min(skip, parts[k].size);
+    parts[k].skip_front += n; parts[k].size -= n; skip -= n;
+  }
+  skip = piece.skip_back;
+  for(size_t k=parts.size(); k>0 && skip > 0; --k){
+    size_t n = min(skip, parts[k-1].size);
+    parts[k-1].skip_back += n; parts[k-1].size -= n; skip -= n;
+  }
+}
+
+void PathStore::writeSegments(const Piece& piece, PATH& path) const{
+  //! write the positions skip_front ... skip_front+size-1 of the traced path
+  const SegmentList& segs = line_vec[piece.index].segs;
+  size_t first = piece.skip_front, last = piece.skip_front + piece.size;
+  size_t pos = 0;
+  for(size_t k=0; k<segs.size() && pos < last; ++k){
+    const Segment& seg = segs[piece.reversed ? segs.size()-1-k : k];
+    size_t n = seg.size();
+    for(size_t i=max(first, pos)-pos; i<n && pos+i<last; ++i)
+      path.push_back(getVertex(seg, piece.reversed ? n-1-i : i));
+    pos += n;
+  }
+}
+
+void PathStore::getPath(int line, PATH& path) const{
+  path.clear();
+  path.reserve(getPathSize(line));
+  //! pieces still to write, the next one at the back
+  PieceArray piece_stack(1, makePiece(PIECE_LINE, line, line_vec[line].join_vec.size(), false));
+  PieceArray parts;
+  while(!piece_stack.empty()){
+    Piece piece = piece_stack.back();
+    piece_stack.pop_back();
+    if(piece.size == 0) continue;
+    if(piece.kind == PIECE_SEGMENTS) { writeSegments(piece, path); continue; }
+    splitPiece(piece, parts);
+    piece_stack.insert(piece_stack.end(), parts.rbegin(), parts.rend());
+  }
+  assert(path.size() == getPathSize(line));
+}
+
+} // end namespace
@@ -0,0 +1,109 @@
+#ifndef PATH_STORE_H_
+#define PATH_STORE_H_
+
+#include <vector>
+#include "mscomplex.h"
+
+namespace msc2d{
+
+  /*
+    Compact storage of integration line paths.
+    The vertices live in runs, immutable sequences in one pool. The traced
+    path of a line is a list of segments, each a slice of a run read
+    forward or backward. Lines merging into the same extremum share the
+    run of their common suffix.
+    A cancellation extends the lines it reroutes with a join, a handle on
+    two other lines as they are at that moment, so extending a line costs
+    O(1) whatever the length of the paths. getPath() expands the joins and
+    is only called for the lines that survive.
+  */
+  class PathStore{
+ public:
+    //! vertices first..last of a run, both included; first > last reads backward
+    struct Segment{
+      int run;
+      int first, last;
+      size_t size() const { return first <= last ? last-first+1 : first-last+1; }
+    };
+    typedef std::vector<Segment> SegmentList;
+
+    PathStore();
+    ~PathStore();
+
+    void clear();
+    /*
+      store a path as a new line, sharing the longest suffix found in the
+      stored runs (checked vertex by vertex, so any path is safe)
+      @return the line index, lines are numbered in order of addition
+    */
+    int addPath(const PATH& path);
+    size_t getLineNumber() const { return line_vec.size(); }
+    /*
+      record the path of line1 backward without its last vertex followed by
+      the path of line2 without its first vertex, both as they are now
+      @return the join index for appendJoin
+    */
+    int addJoin(int line1, int line2);
+    void appendJoin(int line, int join);
+    //! current path size of a line, joins included
+    size_t getPathSize(int line) const { return getPathSize(line, line_vec[line].join_vec.size()); }
+    void getPath(int line, PATH& path) const;
+
+    //! vertices kept in the pool and joins, for the memory statistics
+    size_t getPoolSize() const { return vert_pool.size(); }
+    size_t getJoinNumber() const { return join_vec.size(); }
+ private:
+    struct LineJoin{
+      int join;
+      size_t size; // path size of the line once the join is appended
+    };
+    struct Line{
+      SegmentList segs;
+      size_t seg_size;
+      std::vector<LineJoin> join_vec;
+    };
+    //! line1 and line2 with their first join_num1/join_num2 joins
+    struct Join{
+      int line1, join_num1;
+      int line2, join_num2;
+      size_t size;
+    };
+    enum PIECEKIND{
+      PIECE_SEGMENTS, // traced path of a line
+      PIECE_LINE,     // a line with its first join_num joins
+      PIECE_JOIN
+    };
+    //! part of a path still to be written by getPath, size is without the skipped vertices
+    struct Piece{
+      PIECEKIND kind;
+      int index;    // line, or join for PIECE_JOIN
+      int join_num;
+      bool reversed;
+      size_t skip_front, skip_back, size;
+    };
+    typedef std::vector<Piece> PieceArray;
+
+    int getRunSize(int run) const { return run_offset[run+1] - run_offset[run]; }
+    int addRun(const PATH& path, size_t first, size_t last);
+    size_t getPathSize(int line, size_t join_num) const {
+      return join_num == 0 ? line_vec[line].seg_size : line_vec[line].join_vec[join_num-1].size;
+    }
+    int getVertex(const Segment& seg, size_t i) const {
+      return vert_pool[run_offset[seg.run] + (seg.first <= seg.last ? seg.first+i : seg.first-i)];
+    }
+    Piece makePiece(PIECEKIND kind, int index, int join_num, bool reversed) const;
+    //! parts of a PIECE_LINE or PIECE_JOIN piece in writing order, the skips passed down
+    void splitPiece(const Piece& piece, PieceArray& parts) const;
+    void writeSegments(const Piece& piece, PATH& path) const;
+ private:
+    std::vector<int> vert_pool;
+    //! run r is vert_pool[run_offset[r]] ... vert_pool[run_offset[r+1]-1]
+    std::vector<int> run_offset;
+    std::vector<Line> line_vec;
+    std::vector<Join> join_vec;
+    //! run and position of the first stored occurrence of each vertex, run -1 if none
+    std::vector< std::pair<int, int> > vert_pos_vec;
+  };
+}
+
+#endif
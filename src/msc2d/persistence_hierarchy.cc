@@ -0,0 +1,83 @@
+#include "persistence_hierarchy.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+namespace msc2d{
+
+PersistenceHierarchy::PersistenceHierarchy(){ clear(); }
+PersistenceHierarchy::~PersistenceHierarchy(){}
+
+void PersistenceHierarchy::clear(){
+  max_threshold = -1.0;
+  sum_persistence = 0.0;
+  cancel_vec.clear();
+  rerouted_vec.clear();
+}
+
+size_t PersistenceHierarchy::getPrefixSize(double threshold) const{
+  size_t k = 0;
+  while(k < cancel_vec.size() && cancel_vec[k].persistence <= threshold) ++k;
+  return k;
+}
+
+bool PersistenceHierarchy::save(const string& file_name) const{
+  ofstream os(file_name.c_str());
+  if(!os) {
+    cerr << "Cannot open " << file_name << endl;
+    return false;
+  }
+  //! persistence is written exactly, the prefix depends on it
+  os.precision(17);
+  os << "# Persistence hierarchy: PH max_threshold sum_persistence cancellation_number" << endl;
+  os << "PH " << max_threshold << " " << sum_persistence << " " << cancel_vec.size() << endl;
+  os << "# Cancellations: PC il_index saddle extremum persistence cancelled target rerouted_lines" << endl;
+  for(size_t k=0; k<cancel_vec.size(); ++k){
+    const Cancellation& c = cancel_vec[k];
+    os << "PC " << c.il_index << " " << c.saddle << " " << c.extremum << " "
+       << c.persistence << " " << (c.cancelled ? 1 : 0) << " " << c.target << " " << c.rerouted_num;
+    for(int i=0; i<c.rerouted_num; ++i) os << " " << rerouted_vec[c.rerouted_first+i];
+    os << endl;
+  }
+  return true;
+}
+
+bool PersistenceHierarchy::load(const string& file_name){
+  ifstream fin(file_name.c_str());
+  if(fin.fail()){
+    cerr << "Cannot load persistence hierarchy " << file_name << endl;
+    return false;
+  }
+  clear();
+  size_t cancel_num = 0;
+  bool header = false;
+  string line;
+  while(getline(fin, line)){
+    istringstream is(line);
+    string tag;
+    if(!(is >> tag) || tag[0] == '#') continue;
+    if(tag == "PH"){
+      header = !(is >> max_threshold >> sum_persistence >> cancel_num).fail();
+      cancel_vec.reserve(cancel_num);
+    }else if(tag == "PC"){
+      Cancellation c;
+      int flag = 0;
+      if(!(is >> c.il_index >> c.saddle >> c.extremum >> c.persistence >> flag >> c.target >> c.rerouted_num)) break;
+      c.cancelled = flag != 0;
+      c.rerouted_first = rerouted_vec.size();
+      int il_index;
+      for(int i=0; i<c.rerouted_num && is >> il_index; ++i) rerouted_vec.push_back(il_index);
+      if((int)rerouted_vec.size() != c.rerouted_first + c.rerouted_num) break;
+      cancel_vec.push_back(c);
+    }
+  }
+  if(!header || cancel_vec.size() != cancel_num){
+    cerr << "Broken persistence hierarchy " << file_name << endl;
+    clear();
+    return false;
+  }
+  return true;
+}
+
+} // end namespace
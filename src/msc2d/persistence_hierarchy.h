@@ -0,0 +1,47 @@
+#ifndef PERSISTENCE_HIERARCHY_H_
+#define PERSISTENCE_HIERARCHY_H_
+
+#include <vector>
+#include <string>
+
+namespace msc2d{
+
+  /*
+    Cancellation sequence of a traced complex, recorded once up to a
+    maximal threshold. Simplifor always cancels the line of lowest
+    persistence first, so the complex simplified at any lower threshold
+    is the one obtained after a prefix of the sequence: the cancellations
+    before the first one above the threshold.
+  */
+  class PersistenceHierarchy{
+ public:
+    struct Cancellation{
+      int il_index;       // line taken from the queue, index in the traced complex
+      int saddle;         // its critical points when it was taken
+      int extremum;
+      double persistence; // normalized as in Simplifor
+      bool cancelled;     // false if only the saddle was removed
+      int target;         // extremum receiving the connections, -1 if none
+      int rerouted_first; // lines moved to target are
+      int rerouted_num;   // rerouted_vec[rerouted_first] ...
+    };
+
+    PersistenceHierarchy();
+    ~PersistenceHierarchy();
+
+    void clear();
+    bool empty() const { return cancel_vec.empty() && max_threshold < 0.0; }
+    //! number of cancellations replayed for a threshold
+    size_t getPrefixSize(double threshold) const;
+
+    bool save(const std::string& file_name) const;
+    bool load(const std::string& file_name);
+
+    double max_threshold;   // -1 if nothing recorded
+    double sum_persistence; // normalization of the traced complex
+    std::vector<Cancellation> cancel_vec;
+    std::vector<int> rerouted_vec;
+  };
+}
+
+#endif
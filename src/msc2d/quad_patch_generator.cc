@@ -6,7 +6,8 @@ using namespace std;
 using namespace meshlib;
 
 namespace msc2d{
-QPGenerator::QPGenerator(MSComplex2D& _msc): msc(_msc){}
+QPGenerator::QPGenerator(MSComplex2D& _msc):
+    msc(_msc), mesh(*_msc.mesh), path_finder(*_msc.mesh, _msc.path_search_mode){}
 QPGenerator::~QPGenerator(){}
 
 void QPGenerator::genQuadPatch(){
@@ -118,11 +119,12 @@ void QPGenerator::genTriPatch() {
     PATH boundary(path2.rbegin(), path2.rend());
     boundary.insert(boundary.end(), path1.begin()+1, path1.end());
     const HalfEdgeArray& he_vec = msc.mesh->getHalfEdgeArray();
-    set<int> bd_hes, valid_edge_set;
+    set<int> bd_hes;
+    path_finder.clearAllowedEdges();
     for(size_t i=0; i<boundary.size()-1; ++i){
       HalfEdgeHandle hh = msc.mesh->getHalfEdgeHandle(boundary[i], boundary[i+1]);
       bd_hes.insert(hh);
-      valid_edge_set.insert(he_vec[hh].edge_handle);
+      path_finder.addAllowedEdge(he_vec[hh].edge_handle);
     }
     set<int> visited_faces;
 
@@ -139,7 +141,7 @@ void QPGenerator::genTriPatch() {
         while(!q.empty()){
           int _fid = q.front(); q.pop();
           const EdgeHandleArray& eh_vec = msc.mesh->getFaceEdges(_fid);
-          for(size_t i=0; i<eh_vec.size(); ++i) valid_edge_set.insert(eh_vec[i]);
+          for(size_t i=0; i<eh_vec.size(); ++i) path_finder.addAllowedEdge(eh_vec[i]);
           const HalfEdgeHandleArray& hh_vec = msc.mesh->getFaceHalfEdges(_fid);
           for(size_t i=0; i<hh_vec.size(); ++i){
             if(bd_hes.find(hh_vec[i]) != bd_hes.end()) continue;
@@ -159,7 +161,7 @@ void QPGenerator::genTriPatch() {
     dual_il.startIndex = cp_index1; dual_il.endIndex = cp_index2;
     int start_vid = msc.cp_vec[cp_index1].meshIndex;
     int end_vid = msc.cp_vec[cp_index2].meshIndex;
-    if(msc.mesh->getShortestPath(start_vid, end_vid, dual_il.path, valid_edge_set)){
+    if(path_finder.getShortestPath(start_vid, end_vid, dual_il.path)){
         msc.il_vec.push_back(dual_il);
         msc.qp_vec.push_back(QuadPatch());
         QuadPatch& patch = msc.qp_vec[msc.qp_vec.size()-1];
@@ -184,7 +186,7 @@ CriticalPointNeighbor QPGenerator::getNextCPNeighbor(const CriticalPointNeighbor
   return _nb_vec[(idx+_nb_num-1)%_nb_num];
 }
 
-bool QPGenerator::findPatchInnerFace(QuadPatch& patch) const{
+bool QPGenerator::findPatchInnerFace(QuadPatch& patch){
   PATH bd_loop;
   for(size_t k=0; k<patch.boundaryIntegrationLineIndex.size(); ++k){
     int il_index = patch.boundaryIntegrationLineIndex[k];
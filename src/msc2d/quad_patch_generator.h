@@ -1,4 +1,5 @@
 #include "mscomplex.h"
+#include "../mesh/MeshPathFinder.h"
 #include <map>
 #include <set>
 
@@ -16,7 +17,7 @@ namespace msc2d{
 
  private:
     void genQuadPatch(size_t sad_cp_index);
-    bool findPatchInnerFace(QuadPatch& qp) const;
+    bool findPatchInnerFace(QuadPatch& qp);
     CriticalPointNeighbor getNextCPNeighbor(const CriticalPointNeighbor&) const;
     void genMMSadMapping();
 
@@ -27,6 +28,7 @@ namespace msc2d{
  private:
     MSComplex2D& msc;
     const meshlib::Mesh& mesh;
+    meshlib::MeshPathFinder path_finder;
 
     std::vector< std::vector<int> > formed_patchs;
     // the map between a pair(max, min) to saddles
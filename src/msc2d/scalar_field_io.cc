@@ -0,0 +1,167 @@
+#include "scalar_field_io.h"
+#include "../util/utility.h"
+#include "../util/mappedfile.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+using namespace meshlib;
+
+namespace msc2d{
+
+namespace{
+const char SFB_MAGIC[4] = {'M', 'S', 'F', 'B'};
+const unsigned int SFB_VERSION = 1;
+
+struct SfbHeader{
+  char magic[4];
+  unsigned int version;
+  unsigned long long count;
+  unsigned int dtype;
+  unsigned int reserved;
+  unsigned long long checksum;
+};
+}
+
+bool isBinaryScalarFieldFile(const string& file_name){
+  size_t idx = file_name.rfind('.');
+  if(idx == string::npos) return false;
+  string ext = file_name.substr(idx);
+  Util::MakeLower(ext);
+  return ext == ".sfb";
+}
+
+bool loadScalarFieldText(const string& file_name, vector<double>& sf){
+  ifstream fin(file_name.c_str());
+  if(fin.fail()){
+    cerr << "Cannot load scalar field file " << file_name << endl;
+    return false;
+  }
+
+  sf.clear();
+  size_t vert_num = 0;
+  fin >> vert_num;
+  sf.reserve(vert_num);
+
+  double scalar;
+  while(fin >> scalar){
+    sf.push_back(scalar);
+  }
+
+  if(sf.size() != vert_num){
+    cerr << "Warning : scalar field " << file_name << " declares " << vert_num
+         << " values but contains " << sf.size() << endl;
+  }
+  return true;
+}
+
+bool loadScalarFieldBinary(const string& file_name, vector<double>& sf){
+  MappedFile file;
+  if(!file.open(file_name)){
+    cerr << "Cannot load scalar field file " << file_name << endl;
+    return false;
+  }
+
+  SfbHeader header;
+  if(file.size() < sizeof(header)){
+    cerr << "Broken scalar field file " << file_name << endl;
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+  if(memcmp(header.magic, SFB_MAGIC, 4) != 0 || header.version != SFB_VERSION ||
+     (header.dtype != SFB_FLOAT32 && header.dtype != SFB_FLOAT64)){
+    cerr << "Unsupported scalar field file " << file_name << endl;
+    return false;
+  }
+
+  size_t elem_size = header.dtype == SFB_FLOAT64 ? sizeof(double) : sizeof(float);
+  //! check the count before header.count*elem_size can overflow
+  if(header.count > (file.size() - sizeof(header))/elem_size){
+    cerr << "Truncated scalar field file " << file_name << endl;
+    return false;
+  }
+  size_t bytes = header.count * elem_size;
+  const char* values = file.data() + sizeof(header);
+  if(Util::Hash64(values, bytes) != header.checksum){
+    cerr << "Checksum mismatch in scalar field file " << file_name << endl;
+    return false;
+  }
+
+  sf.resize(header.count);
+  if(header.count == 0) return true;
+  if(header.dtype == SFB_FLOAT64){
+    memcpy(&sf[0], values, bytes);
+  }else{
+    const float* fv = (const float*)values;
+    for(size_t i=0; i<sf.size(); ++i) sf[i] = fv[i];
+  }
+  return true;
+}
+
+bool saveScalarFieldBinary(const string& file_name, const vector<double>& sf,
+                           ScalarFieldDType dtype){
+  ofstream fout(file_name.c_str(), ios::binary);
+  if(fout.fail()){
+    cerr << "Cannot write scalar field file " << file_name << endl;
+    return false;
+  }
+
+  vector<float> fv;
+  const char* values = sf.empty() ? NULL : (const char*)&sf[0];
+  size_t bytes = sf.size()*sizeof(double);
+  if(dtype == SFB_FLOAT32){
+    fv.assign(sf.begin(), sf.end());
+    values = fv.empty() ? NULL : (const char*)&fv[0];
+    bytes = fv.size()*sizeof(float);
+  }
+
+  SfbHeader header;
+  memcpy(header.magic, SFB_MAGIC, 4);
+  header.version = SFB_VERSION;
+  header.count = sf.size();
+  header.dtype = dtype;
+  header.reserved = 0;
+  header.checksum = Util::Hash64(values, bytes);
+  fout.write((const char*)&header, sizeof(header));
+  if(bytes) fout.write(values, bytes);
+
+  if(fout.fail()){
+    fout.close(); remove(file_name.c_str());
+    cerr << "Cannot write scalar field file " << file_name << endl;
+    return false;
+  }
+  return true;
+}
+
+bool convertScalarField(const string& sf_name, const string& sfb_name,
+                        ScalarFieldDType dtype){
+  vector<double> sf;
+  if(!loadScalarFieldText(sf_name, sf)) return false;
+  return saveScalarFieldBinary(sfb_name, sf, dtype);
+}
+bool loadMultiScalarField(const string& file_name, vector< vector<double> >& fields){
+  ifstream fin(file_name.c_str());
+  if(fin.fail()){
+    cerr << "Cannot load scalar field file " << file_name << endl;
+    return false;
+  }
+
+  size_t vert_num = 0, field_num = 0;
+  fin >> vert_num >> field_num;
+  fields.clear();
+  fields.resize(field_num);
+  for(size_t k=0; k<field_num; ++k) fields[k].resize(vert_num);
+
+  for(size_t i=0; i<vert_num; ++i){
+    for(size_t k=0; k<field_num; ++k){
+      if(!(fin >> fields[k][i])){
+        cerr << "Error: scalar field " << file_name << " ends at row " << i << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
@@ -0,0 +1,43 @@
+#ifndef scalar_field_io_h_
+#define scalar_field_io_h_
+
+#include <vector>
+#include <string>
+
+namespace msc2d{
+
+  /*
+    .sfb binary scalar field layout (little endian):
+      char     magic[4]   "MSFB"
+      uint32   version
+      uint64   count      number of values
+      uint32   dtype      SFB_FLOAT32 or SFB_FLOAT64
+      uint32   reserved
+      uint64   checksum   Util::Hash64 of the value bytes
+      values   count * sizeof(dtype)
+   */
+  enum ScalarFieldDType{
+    SFB_FLOAT32 = 0,
+    SFB_FLOAT64 = 1
+  };
+
+  //! text .sf: value count followed by the values
+  bool loadScalarFieldText(const std::string& file_name, std::vector<double>& sf);
+  //! binary .sfb, values are copied straight out of the mapped file
+  bool loadScalarFieldBinary(const std::string& file_name, std::vector<double>& sf);
+  bool saveScalarFieldBinary(const std::string& file_name, const std::vector<double>& sf,
+                             ScalarFieldDType dtype = SFB_FLOAT64);
+  //! convert a text .sf file into a binary .sfb file
+  bool convertScalarField(const std::string& sf_name, const std::string& sfb_name,
+                          ScalarFieldDType dtype = SFB_FLOAT64);
+  bool isBinaryScalarFieldFile(const std::string& file_name);
+
+  /*
+    multi-column text .msf: "N K" followed by N rows of K values,
+    column k is the k-th scalar field over the N vertices
+   */
+  bool loadMultiScalarField(const std::string& file_name,
+                            std::vector< std::vector<double> >& fields);
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef upper_link_h_
+#define upper_link_h_
+
+#include <cstddef>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace msc2d{
+
+  /*
+    Upper link bitmask of a vertex: bit k is set when the k-th one-ring
+    neighbor ranks above the vertex. A ring of n neighbors takes
+    linkWordNumber(n) words, the bits past n are zero.
+  */
+  typedef unsigned long long LinkWord;
+  const size_t LINK_WORD_BITS = 64;
+
+  inline size_t linkWordNumber(size_t n){
+    return (n + LINK_WORD_BITS - 1) / LINK_WORD_BITS;
+  }
+
+  inline bool testLinkBit(const LinkWord* mask, size_t k){
+    return (mask[k / LINK_WORD_BITS] >> (k % LINK_WORD_BITS)) & 1;
+  }
+
+  inline int popCount(LinkWord w){
+#ifdef __GNUC__
+    return __builtin_popcountll(w);
+#else
+    int c = 0;
+    for(; w; w &= w-1) ++c;
+    return c;
+#endif
+  }
+
+  /*
+    fill the mask of a vertex from the ranks of its ring, four neighbors
+    per SSE2 compare
+    @param rank: rank of every mesh vertex
+    @param adj: the n one-ring neighbors of the vertex
+  */
+  inline void computeUpperLink(const unsigned int* rank, unsigned int vert_rank,
+                               const int* adj, size_t n, LinkWord* mask){
+    size_t word_num = linkWordNumber(n);
+    for(size_t w=0; w<word_num; ++w) mask[w] = 0;
+    size_t k = 0;
+#ifdef __SSE2__
+    //! ranks are unsigned, flip the sign bit for the signed compare
+    const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+    const __m128i vr = _mm_xor_si128(_mm_set1_epi32((int)vert_rank), bias);
+    for(; k+4 <= n; k += 4){
+      __m128i r = _mm_set_epi32((int)rank[adj[k+3]], (int)rank[adj[k+2]],
+                                (int)rank[adj[k+1]], (int)rank[adj[k]]);
+      __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(r, bias), vr);
+      LinkWord bits = (LinkWord)_mm_movemask_ps(_mm_castsi128_ps(gt));
+      mask[k / LINK_WORD_BITS] |= bits << (k % LINK_WORD_BITS);
+    }
+#endif
+    for(; k<n; ++k){
+      if(rank[adj[k]] > vert_rank) mask[k / LINK_WORD_BITS] |= (LinkWord)1 << (k % LINK_WORD_BITS);
+    }
+  }
+
+  /*
+    number of changes between upper and lower neighbors around the ring,
+    the popcount of mask ^ rotate(mask). an open (boundary) ring is
+    counted as if closed by its mirror image, which doubles the changes
+    of the open sequence.
+  */
+  inline int countLinkAlternations(const LinkWord* mask, size_t n, bool open){
+    if(n == 0) return 0;
+    size_t word_num = linkWordNumber(n);
+    //! the bit before bit 0 of a closed ring is bit n-1
+    LinkWord carry = testLinkBit(mask, n-1) ? 1 : 0;
+    LinkWord first_change = (mask[0] ^ carry) & 1;
+    int alter_num = 0;
+    for(size_t w=0; w<word_num; ++w){
+      LinkWord diff = mask[w] ^ ((mask[w] << 1) | carry);
+      carry = mask[w] >> (LINK_WORD_BITS-1);
+      size_t valid = (w+1 == word_num) ? n - w*LINK_WORD_BITS : LINK_WORD_BITS;
+      if(valid < LINK_WORD_BITS) diff &= ((LinkWord)1 << valid) - 1;
+      alter_num += popCount(diff);
+    }
+    if(open) alter_num = 2*(alter_num - (int)first_change);
+    return alter_num;
+  }
+}
+
+#endif
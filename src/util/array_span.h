@@ -0,0 +1,40 @@
+#ifndef _UTIL_ARRAY_SPAN_H
+#define _UTIL_ARRAY_SPAN_H
+
+#include <vector>
+#include <cstddef>
+
+namespace meshlib{
+
+/**
+ * read-only view of a contiguous run of elements, such as one row of a
+ * compressed sparse row array. it does not own the elements, so it is
+ * only valid as long as the array it points into is not resized.
+ */
+template <class T>
+class ArraySpan
+{
+public:
+	typedef T value_type ;
+	typedef const T* const_iterator ;
+
+	ArraySpan() : first_(NULL), last_(NULL) {}
+	ArraySpan(const T* first, const T* last) : first_(first), last_(last) {}
+	explicit ArraySpan(const std::vector<T>& vec) :
+		first_(vec.empty() ? NULL : &vec[0]), last_(first_ + vec.size()) {}
+
+	size_t size() const { return last_ - first_ ; }
+	bool empty() const { return first_ == last_ ; }
+	const T& operator[](size_t i) const { return first_[i] ; }
+	const T& front() const { return *first_ ; }
+	const T& back() const { return *(last_-1) ; }
+	const_iterator begin() const { return first_ ; }
+	const_iterator end() const { return last_ ; }
+
+private:
+	const T* first_ ;
+	const T* last_ ;
+} ;
+
+}
+#endif
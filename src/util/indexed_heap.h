@@ -0,0 +1,139 @@
+#ifndef _UTIL_INDEXED_HEAP_H
+#define _UTIL_INDEXED_HEAP_H
+
+#include <vector>
+#include <cassert>
+
+namespace meshlib{
+
+/**
+ * D-ary min heap of integer ids in [0, capacity) with one key per id.
+ * the position of every id is tracked, so contains() is O(1) and
+ * decrease() is O(log n) instead of a linear search.
+ *
+ * sift rules follow CHeap: an item moves up past parents whose key is
+ * not smaller, and moves down only below a strictly smaller child,
+ * choosing the first of equal children. with D = 2 items are therefore
+ * popped in exactly the same order as from CHeap.
+ */
+template <class Key, int D = 4>
+class IndexedHeap
+{
+public:
+	explicit IndexedHeap(size_t capacity = 0) : pos_(capacity, -1) {}
+
+	//! ids must be smaller than capacity, clears the heap
+	void reserve(size_t capacity) { clear() ; pos_.assign(capacity, -1) ; }
+	size_t capacity() const { return pos_.size() ; }
+
+	bool empty() const { return heap_.empty() ; }
+	size_t size() const { return heap_.size() ; }
+	bool contains(int id) const { return pos_[id] != -1 ; }
+	const Key& key(int id) const { return heap_[pos_[id]].key ; }
+
+	int top() const { return heap_[0].id ; }
+	const Key& topKey() const { return heap_[0].key ; }
+
+	void push(int id, const Key& key) {
+		assert(pos_[id] == -1) ;
+		Entry e = {key, id} ;
+		heap_.push_back(e) ;
+		pos_[id] = (int)heap_.size()-1 ;
+		siftUp(heap_.size()-1) ;
+	}
+
+	//! the new key must not be larger than the current one
+	void decrease(int id, const Key& key) {
+		heap_[pos_[id]].key = key ;
+		siftUp(pos_[id]) ;
+	}
+
+	//! push id, or lower its key if it is already in the heap
+	void pushOrDecrease(int id, const Key& key) {
+		if(pos_[id] == -1) push(id, key) ;
+		else decrease(id, key) ;
+	}
+
+	//! any new key, moves the id up or down as needed
+	void update(int id, const Key& key) {
+		size_t k = pos_[id] ;
+		heap_[k].key = key ;
+		siftUp(k) ;
+		siftDown(pos_[id]) ;
+	}
+
+	int pop() {
+		int id = heap_[0].id ;
+		pos_[id] = -1 ;
+		Entry last = heap_.back() ;
+		heap_.pop_back() ;
+		if(!heap_.empty()) {
+			heap_[0] = last ;
+			pos_[last.id] = 0 ;
+			siftDown(0) ;
+		}
+		return id ;
+	}
+
+	void erase(int id) {
+		size_t k = pos_[id] ;
+		pos_[id] = -1 ;
+		Entry last = heap_.back() ;
+		heap_.pop_back() ;
+		if(k == heap_.size()) return ;
+		heap_[k] = last ;
+		pos_[last.id] = (int)k ;
+		siftUp(k) ;
+		siftDown(pos_[last.id]) ;
+	}
+
+	//! O(size), only the ids still in the heap are reset
+	void clear() {
+		for(size_t k = 0; k < heap_.size(); ++k) pos_[heap_[k].id] = -1 ;
+		heap_.clear() ;
+	}
+
+private:
+	struct Entry {
+		Key key ;
+		int id ;
+	} ;
+
+	void siftUp(size_t k) {
+		Entry e = heap_[k] ;
+		while(k > 0) {
+			size_t parent = (k-1)/D ;
+			if(heap_[parent].key < e.key) break ;
+			heap_[k] = heap_[parent] ;
+			pos_[heap_[k].id] = (int)k ;
+			k = parent ;
+		}
+		heap_[k] = e ;
+		pos_[e.id] = (int)k ;
+	}
+
+	void siftDown(size_t k) {
+		Entry e = heap_[k] ;
+		size_t n = heap_.size() ;
+		while(true) {
+			size_t first = D*k+1 ;
+			if(first >= n) break ;
+			size_t last = first+D < n ? first+D : n ;
+			size_t j = first ;
+			for(size_t c = first+1; c < last; ++c)
+				if(heap_[c].key < heap_[j].key) j = c ;
+			if(!(heap_[j].key < e.key)) break ;
+			heap_[k] = heap_[j] ;
+			pos_[heap_[k].id] = (int)k ;
+			k = j ;
+		}
+		heap_[k] = e ;
+		pos_[e.id] = (int)k ;
+	}
+
+	std::vector<Entry> heap_ ;
+	std::vector<int> pos_ ;
+} ;
+
+}
+#endif
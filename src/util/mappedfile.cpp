@@ -0,0 +1,76 @@
+#include "mappedfile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//_________________________________________________________
+
+namespace meshlib{
+MappedFile::MappedFile() : data_(NULL), size_(0), opened_(false) {
+#ifdef WIN32
+	file_ = INVALID_HANDLE_VALUE ;
+	mapping_ = NULL ;
+#endif
+}
+
+MappedFile::~MappedFile() {
+	close() ;
+}
+
+bool MappedFile::open(const std::string& filename) {
+	close() ;
+#ifdef WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+	                          OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL) ;
+	if(file == INVALID_HANDLE_VALUE) return false ;
+	LARGE_INTEGER file_size ;
+	if(!GetFileSizeEx(file, &file_size)) { CloseHandle(file) ; return false ; }
+	file_ = file ;
+	size_ = (size_t)file_size.QuadPart ;
+	opened_ = true ;
+	if(size_ == 0) return true ;
+	mapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) ;
+	if(mapping_ == NULL) { close() ; return false ; }
+	data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) ;
+	if(data_ == NULL) { close() ; return false ; }
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY) ;
+	if(fd < 0) return false ;
+	struct stat st ;
+	if(fstat(fd, &st) != 0) { ::close(fd) ; return false ; }
+	size_ = (size_t)st.st_size ;
+	opened_ = true ;
+	if(size_ != 0) {
+		void* p = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0) ;
+		if(p == MAP_FAILED) { ::close(fd) ; size_ = 0 ; opened_ = false ; return false ; }
+		madvise(p, size_, MADV_SEQUENTIAL) ;
+		data_ = (const char*)p ;
+	}
+	// the mapping stays valid after the descriptor is closed
+	::close(fd) ;
+#endif
+	return true ;
+}
+
+void MappedFile::close() {
+#ifdef WIN32
+	if(data_) UnmapViewOfFile(data_) ;
+	if(mapping_) CloseHandle(mapping_) ;
+	if(file_ != INVALID_HANDLE_VALUE) CloseHandle(file_) ;
+	mapping_ = NULL ;
+	file_ = INVALID_HANDLE_VALUE ;
+#else
+	if(data_) munmap((void*)data_, size_) ;
+#endif
+	data_ = NULL ;
+	size_ = 0 ;
+	opened_ = false ;
+}
+}
@@ -0,0 +1,39 @@
+#ifndef _BASIC_OS_MAPPEDFILE_H
+#define _BASIC_OS_MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace meshlib{
+//______________________________________________________________________
+/**
+ * read-only memory mapping of a whole file, the mapping is released
+ * on close() or destruction.
+ */
+class MappedFile {
+public :
+	MappedFile() ;
+	~MappedFile() ;
+
+	bool open(const std::string& filename) ;
+	void close() ;
+
+	bool isOpen() const { return opened_ ; }
+	const char* data() const { return data_ ; }
+	size_t size() const { return size_ ; }
+
+private:
+	MappedFile(const MappedFile&) ;
+	MappedFile& operator=(const MappedFile&) ;
+
+	const char* data_ ;
+	size_t size_ ;
+	bool opened_ ;
+#ifdef WIN32
+	void* file_ ;
+	void* mapping_ ;
+#endif
+} ;
+
+}
+#endif
@@ -0,0 +1,90 @@
+#ifndef _UTIL_RADIX_SORT_H
+#define _UTIL_RADIX_SORT_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace meshlib{
+
+/**
+ * maps a double to an unsigned key with the same order, so doubles can be
+ * radix sorted. -0.0 and 0.0 get the same key.
+ */
+inline unsigned long long RadixKey(double x)
+{
+	if(x == 0.0) x = 0.0 ;
+	unsigned long long bits ;
+	std::memcpy(&bits, &x, sizeof(bits)) ;
+	const unsigned long long SIGN = 1ULL << 63 ;
+	return (bits & SIGN) ? ~bits : (bits | SIGN) ;
+}
+
+//! inputs smaller than this are sorted by a single thread
+const size_t RADIX_SORT_PARALLEL_SIZE = 1<<16;
+
+/**
+ * stable LSD radix sort of (key, value) pairs by key, 8 bits per pass.
+ * only the low key_bits bits of the keys are looked at, passes in which
+ * all keys share the same digit are skipped. every pass counts digits
+ * per chunk and scatters the chunks in order, so the result does not
+ * depend on the number of threads.
+ */
+template <class T>
+void RadixSort(std::vector< std::pair<unsigned long long, T> >& vec, int key_bits = 64)
+{
+	typedef std::pair<unsigned long long, T> Item ;
+	const int RADIX = 256 ;
+	int n = (int)vec.size() ;
+	if(n < 2) return ;
+
+	int chunk_num = 1 ;
+#ifdef _OPENMP
+	if(vec.size() >= RADIX_SORT_PARALLEL_SIZE) chunk_num = omp_get_max_threads() ;
+#endif
+	std::vector<Item> buf(vec.size()) ;
+	std::vector<size_t> hist(chunk_num*RADIX) ;
+
+	for(int shift = 0; shift < key_bits; shift += 8){
+		std::fill(hist.begin(), hist.end(), 0) ;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(chunk_num > 1)
+#endif
+		for(int c = 0; c < chunk_num; ++c){
+			size_t* h = &hist[c*RADIX] ;
+			int first = (int)((long long)n*c/chunk_num), last = (int)((long long)n*(c+1)/chunk_num) ;
+			for(int i = first; i < last; ++i) ++h[(vec[i].first >> shift) & 0xff] ;
+		}
+
+		//! digit major, chunk minor exclusive prefix sum
+		size_t sum = 0 ;
+		bool trivial = false ;
+		for(int d = 0; d < RADIX; ++d){
+			size_t digit_sum = sum ;
+			for(int c = 0; c < chunk_num; ++c){
+				size_t cnt = hist[c*RADIX+d] ;
+				hist[c*RADIX+d] = sum ;
+				sum += cnt ;
+			}
+			if(sum - digit_sum == (size_t)n) trivial = true ;
+		}
+		if(trivial) continue ;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) if(chunk_num > 1)
+#endif
+		for(int c = 0; c < chunk_num; ++c){
+			size_t* h = &hist[c*RADIX] ;
+			int first = (int)((long long)n*c/chunk_num), last = (int)((long long)n*(c+1)/chunk_num) ;
+			for(int i = first; i < last; ++i) buf[h[(vec[i].first >> shift) & 0xff]++] = vec[i] ;
+		}
+		vec.swap(buf) ;
+	}
+}
+
+}
+#endif
@@ -44,4 +44,15 @@ void Util::MakeUpper(std::string& str)
         if(ch >= 'a' && ch <= 'a') ch = ch - 'a' + 'A';
     }
 }
+
+unsigned long long Util::Hash64(const void* data, size_t size, unsigned long long seed)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned long long h = seed;
+    for(size_t i = 0; i < size; ++ i){
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
 }
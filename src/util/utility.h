@@ -3,6 +3,7 @@
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include "array_span.h"
 
 namespace meshlib{
 
@@ -14,6 +15,10 @@ public:
 	static void MakeLower(std::string& str);
 	static void MakeUpper(std::string& str);
 
+    // FNV-1a 64 bit hash of a memory block
+    static unsigned long long Hash64(const void* data, size_t size,
+                                     unsigned long long seed = 14695981039346656037ULL);
+
     // Free various vectors
     template <class T>
     static  void FreeVector(T& arr){
@@ -41,6 +46,10 @@ public:
         static bool isIn(const std::vector<T>& v, const T& x) {
       return find(v.begin(), v.end(), x) != v.end();
     }
+    template <class T>
+        static bool isIn(const ArraySpan<T>& v, const T& x) {
+      return std::find(v.begin(), v.end(), x) != v.end();
+    }
 };
 
 }